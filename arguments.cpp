@@ -0,0 +1,284 @@
+#include "arguments.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+#include "checkpoint.hpp"
+
+
+namespace po = boost::program_options;
+using namespace std;
+
+
+// Parses comma-separated list of times in days, or reads the first column of
+// the file if value is name of existing file
+static vector<double> parse_times(const string &value, const string &option){
+	vector<double> times;
+	ifstream file(value);
+	string line;
+	while ( file and getline(file, line) ){
+		istringstream columns(line);
+		double t;
+		if ( line.empty() or line.front() == '#' ){
+			continue;
+		}
+		if ( not (columns >> t) ){
+			throw po::error("Wrong line in " + value + ": " + line);
+		}
+		times.push_back(t * DAY);
+	}
+	if ( not file.is_open() ){
+		istringstream list(value);
+		string time;
+		while ( getline(list, time, ',') ){
+			try{
+				times.push_back(stod(time) * DAY);
+			} catch (logic_error &){
+				throw po::error("Wrong time in --" + option + ": " + time);
+			}
+		}
+	}
+	sort(times.begin(), times.end());
+	return times;
+}
+
+
+po::options_description FreddiArguments::description(){
+	const FreddiArguments def;
+
+	po::options_description desc("Freddi - numerical calculation of accretion disc evolution");
+
+	po::options_description general("General options");
+	general.add_options()
+		( "help,h", "Produce help message" )
+		( "prefix", po::value<string>()->default_value(def.filename_prefix), "Prefix for output filenames. File with temporal distributions of parameters is PREFIX.dat" )
+		( "dir,d", po::value<string>()->default_value(def.output_dir), "Directory to write output files. It should exist" )
+		( "fulldata", "Output files PREFIX_%d.dat with radial structure for every computed time step. Default is to output only PREFIX.dat with global disk parameters for every time step" )
+		( "fulldataformat", po::value<string>()->default_value(def.fulldata_format), "Format of --fulldata output: text (PREFIX_%d.dat files) or binary (one file PREFIX_fulldata.bin with all time steps, use freddi-fulldata to convert it into text files)" )
+		( "outputevery", po::value<int>(), "Output every N-th time step. 0 means that only time steps chosen by --outputtimes and --outputlog are output. Default is to output every time step if --outputtimes and --outputlog are not specified and 0 otherwise" )
+		( "outputtimes", po::value<string>(), "Times, days: comma-separated list or name of file with times in the first column. The first time step not earlier than every of these times is output" )
+		( "outputlog", po::value<double>(), "Output time steps logarithmically spaced in time with this number of steps per decade, starting from --tau. The first time step is output too" )
+		( "telemetry", "Output file PREFIX_telemetry.dat with number of solver iterations, final residual, whether divergence heuristic fired and wall time of solver, W(h, F) evaluations, X-ray spectrum, photometry and output for every time step. Summary table is written to the end of the file" )
+		( "checkpointevery", po::value<int>()->default_value(def.checkpoint_every), "Write state of the disc to PREFIX_checkpoint.bin every N time steps and after the last step, 0 means no checkpoints. Calculation can be continued from this file by --restart. freddi-sweep doesn't write checkpoints" )
+		( "restart", po::value<string>(), "Continue calculation from the checkpoint file written by --checkpointevery. Options are taken from the checkpoint, options specified explicitly replace them, so many calculations with different parameters can be started from one checkpoint. Options of the grid shouldn't be changed. Output files contain time steps after the checkpoint only" )
+		( "obstimes", po::value<string>(), "Observation times, days: comma-separated list or name of file with times in the first column. Disc state is linearly interpolated between computed time steps to these times, global parameters for them are written to PREFIX_obs.dat. They don't depend on --outputevery, --outputtimes and --outputlog. freddi-sweep writes them together with other time steps" )
+	;
+	desc.add(general);
+
+	po::options_description binary("Basic binary and disc parameters");
+	binary.add_options()
+		( "Mx,M", po::value<double>()->default_value(def.Mx/GSL_CONST_CGSM_SOLAR_MASS), "Mass of the central object, solar masses" )
+		( "kerr", po::value<double>()->default_value(def.kerr), "Kerr parameter of the black hole" )
+		( "alpha,a", po::value<double>()->default_value(def.alpha), "Alpha parameter" )
+		( "rin", po::value<double>(), "Internal radius of the disk, Schwarzschild radii of the central object. If it isn't setted then it will be calculated as radius of ISCO orbit using --Mx and --kerr values" )
+		( "Mopt",	po::value<double>()->default_value(def.Mopt/GSL_CONST_CGSM_SOLAR_MASS), "Mass of optical star, solar masses" )
+		( "period,P", po::value<double>()->default_value(def.P/DAY), "Orbital period of binary system, days" )
+		( "rout,R", po::value<double>()->default_value(def.r_out/solar_radius), "Outer radius of the disk, solar radii. If it isn't setted then it will be calculated as tidal radius using --Mx, --Mopt and --period" )
+		( "inclination,i", po::value<double>()->default_value(def.inclination), "Inclination of the system, degrees" )
+	;
+	desc.add(binary);
+
+	po::options_description internal("Parameters of the disc model");
+	internal.add_options()
+		( "opacity,O", po::value<string>()->default_value(def.opacity_type), "Opacity law: Kramers (varkappa ~ rho / T^7/2), OPAL (varkappa ~ rho / T^5/2) or table (Rosseland mean opacity from --opacitytable file)" )
+		( "opacitytable", po::value<string>(), "File with Rosseland mean opacity table for --opacity=table in the format of OPAL tables. The first line is a label followed by values of log R, where R = rho / T6^3, rho is in g/cm^3 and T6 = T / 1e6 K. Every next line is log T followed by values of log varkappa (cm^2/g) for every log R, missing values at the end of a line are taken equal to the last value. Lines started with # are ignored. Vertical structure of the disc is calculated once with constants Pi1..Pi4 of OPAL law and is interpolated during the evolution" )
+		( "boundcond", po::value<string>()->default_value(def.bound_cond_type), "Outer boundary movement condition\n\n"
+			"Values:\n"
+			"  Teff: outer radius of the disc moves inside to keep photosphere temperature of the disc larger than some value. This value is specified by --Thot option\n"
+			"  Tirr: outer radius of the disc moves inside to keep irradiation flux of the disc larger than some value. The value of this minimal irradiation flux is [Stefan-Boltzmann constant] * Tirr^4, where Tirr is specified by --Thot option" ) // fourSigmaCrit, MdotOut
+		( "Thot", po::value<double>()->default_value(def.T_min_hot_disk), "Minimum photosphere of irradiation temperature of the outer edge of the hot disk, degrees Kelvin. For details see --boundcond description" )
+		( "F0", po::value<double>()->default_value(def.F0), "Initial viscous torque on outer boundary of the disk, cgs" )
+		( "Mdot0", po::value<double>()->default_value(def.Mdot0), "Initial mass accretion rate, g/s. If both --F0 and --Mdot0 are specified then --Mdot0 is used. Works only when --initialcond is setted to sinusF or quasistat" )
+		( "initialcond", po::value<string>()->default_value(def.initial_cond_shape), "Initial condition viscous torque F or surface density Sigma\n\n"
+			"Values:\n"
+			"  powerF: F ~ xi^powerorder, powerorder is specified by --powerorder option\n" // power option does the same
+			"  powerSigma: Sigma ~ xi^powerorder, powerorder is specified by --powerorder option\n"
+			"  sinusF: F ~ sin( xi * pi/2 )\n" // sinus option does the same
+			"  quasistat: F ~ f(h/h_out) * xi * h_out/h, where f is quasi-stationary solution found in Lipunova & Shakura 2000. f(xi=0) = 0, df/dxi(xi=1) = 0\n\n"
+			"Here xi is (h - h_in) / (h_out - h_in)\n") // sinusparabola, sinusgauss
+		( "powerorder", po::value<double>()->default_value(def.power_order), "Parameter of the powerlaw initial condition distributions. This option works only with --initialcond=powerF and =powerSigma" )
+	;
+	desc.add(internal);
+
+	po::options_description x_ray("Parameters of X-ray emission");
+	x_ray.add_options()
+		( "Cirr", po::value<double>()->default_value(def.C_irr_input), "Irradiation factor" )
+		( "irrfactortype", po::value<string>()->default_value(def.irr_factor_type), "Type of irradiation factor Cirr: const (doesn't depend on disk shape, [rad. flux] = Cirr  L / [4 pi r^2]), square (disk has polynomial shape, [rad. flux] = Cirr L / [4 pi r^2] [z/r]^2 )" )
+		( "dilution", po::value<double>()->default_value(def.fc), "Dilution parameter"  )
+		( "numin", po::value<double>()->default_value(def.nu_min/keV), "Lower bound of X-ray band, keV" )
+		( "numax", po::value<double>()->default_value(def.nu_max/keV), "Upper bound of X-ray band, keV" )
+		( "bandtable", po::value<int>()->default_value(def.band_table_size), "Size of the table of Planck function integrated over X-ray band against temperature, the table is used to calculate X-ray luminosity. 0 means direct integration over 100 frequencies for every radius at every time step, it is slower and is intended for validation" )
+		( "bandtablenu", po::value<int>()->default_value(def.band_table_Nnu), "Number of frequencies used to integrate Planck function for every temperature of the table, see --bandtable" )
+	;
+	desc.add(x_ray);
+
+	po::options_description optical("Parameters for optical magnitudes calculation");
+	optical.add_options()
+		( "distance", po::value<double>()->default_value(def.Distance/kpc), "Distance to the system, kpc" )
+		( "filters", po::value<string>(), "File with photometric bands, magnitudes in these bands are written to PREFIX.dat instead of U, B, V, R, I and J. Every line of the file is 'NAME ZERO_POINT WAVELENGTH', where ZERO_POINT is zero magnitude flux density in erg/s/cm^2/A or in Jy if it has suffix Jy, e.g. 1600Jy. WAVELENGTH is effective wavelength in A or name of the file with transmission curve: wavelength in A and transmission in two columns. Lines started with # are ignored" )
+	;
+	desc.add(optical);
+
+	po::options_description numeric("Parameters of disc evolution calculation");
+	numeric.add_options()
+		( "time,T", po::value<double>()->default_value(def.Time/DAY), "Computation time, days" )
+		( "tau",	po::value<double>()->default_value(def.tau/DAY), "Time step, days. With --adaptive it is the initial time step" )
+		( "adaptive", "Use adaptive time step. Every step is computed twice, by one step and by two half steps, their difference is used to keep relative error of viscous torque F less than --rtol. Steps where the solver diverges are repeated with smaller step. Time step of every step is written to PREFIX.dat" )
+		( "rtol", po::value<double>()->default_value(def.tau_rtol), "Maximum relative local error of viscous torque F for one time step. This option works only with --adaptive" )
+		( "taumin", po::value<double>()->default_value(def.tau_min/DAY), "Minimum time step, days. Calculation stops if the step should be smaller. This option works only with --adaptive" )
+		( "taumax", po::value<double>()->default_value(def.tau_max/DAY), "Maximum time step, days. This option works only with --adaptive" )
+		( "Nx",	po::value<int>()->default_value(def.Nx), "Size of calculation grid" )
+		( "gridscale", po::value<string>()->default_value(def.grid_scale), "Type of grid for angular momentum h: log or linear" )
+		( "remesh", po::value<double>()->default_value(def.remesh_fraction), "Rebuild the grid when the outer boundary of the hot disc moves inside and less than this fraction of --Nx points is left, e.g. 0.9 rebuilds it when 10% of points are cut off. The new grid has --Nx points between the inner radius and the outer boundary, F is interpolated by monotone cubic spline and is scaled to keep the mass of the disc. 0 means that the grid is only truncated, so the resolution decreases with the disc size" )
+		( "refine", po::value<double>()->default_value(def.refine), "Concentration of grid points near the outer boundary, where the ionisation front is, and where F changes fast. Density of points is the sum of --gridscale density, refine/2 times density proportional to h^3 and refine/2 times density proportional to |dF/dh|, every term normalised to one. The initial grid and grids rebuilt by --remesh are refined, 0 means --gridscale spacing. E.g. --Nx=200 --remesh=0.9 --refine=2 is about as accurate as --Nx=1000 without them" )
+		( "solver", po::value<string>()->default_value(def.nonlinear_solver), "Method to solve nonlinear equations of implicit time step: picard (simple iterations) or newton (Newton-Raphson method, it needs less iterations and is stable for larger --tau)" )
+		( "timescheme", po::value<string>()->default_value(def.time_scheme), "Time integration scheme: euler (implicit Euler method, first order in time) or bdf2 (second order backward differentiation formula, it uses F of the previous step and gives the same accuracy with several times larger --tau). The first step of bdf2 is implicit Euler step. Use bdf2 with --solver=newton, because error of simple iterations accumulates over steps. Evolution with moving outer boundary is first order in time for both schemes" )
+		( "solverthreads", po::value<int>()->default_value(def.solver_threads), "Number of threads of the solver for grids of at least --parallelthreshold points, 0 means number of CPU cores. freddi-sweep computes every model by one thread" )
+		( "parallelthreshold", po::value<int>()->default_value(def.parallel_threshold), "Minimum size of the grid solved by blocks of 4096 points in parallel. Tridiagonal systems of such grids are solved by partition method, the result doesn't depend on --solverthreads, but it is slightly different from the result of the sequential method. 0 means that the sequential method is always used" )
+	;
+	desc.add(numeric);
+
+	return desc;
+}
+
+
+void FreddiArguments::store_restart_options(po::variables_map &vm){
+	if ( not vm.count("restart") ){
+		return;
+	}
+	const auto checkpoint = read_checkpoint(vm["restart"].as<string>());
+	po::store( po::command_line_parser(checkpoint.options).options(description()).run(), vm );
+}
+
+
+FreddiArguments::FreddiArguments(const po::variables_map &vm){
+	const auto desc = description();
+	for ( const auto &option : vm ){
+		const auto *description = desc.find_nothrow(option.first, false);
+		if ( option.second.defaulted() or description == nullptr or option.first == "restart" ){
+			continue;
+		}
+		ostringstream value;
+		value << "--" << option.first;
+		const auto &any = option.second.value();
+		if ( description->semantic()->max_tokens() > 0 ){
+			value << "=";
+			if ( any.type() == typeid(double) ){
+				value << setprecision(numeric_limits<double>::max_digits10) << boost::any_cast<double>(any);
+			} else if ( any.type() == typeid(int) ){
+				value << boost::any_cast<int>(any);
+			} else{
+				value << boost::any_cast<string>(any);
+			}
+		}
+		options.push_back(value.str());
+	}
+
+	filename_prefix = vm["prefix"].as<string>();
+	output_dir = vm["dir"].as<string>();
+	output_fulldata = vm.count("fulldata");
+	fulldata_format = vm["fulldataformat"].as<string>();
+	if ( vm.count("outputtimes") ){
+		output_times = parse_times(vm["outputtimes"].as<string>(), "outputtimes");
+	}
+	telemetry = vm.count("telemetry");
+	checkpoint_every = vm["checkpointevery"].as<int>();
+	if ( vm.count("restart") ){
+		restart_filename = vm["restart"].as<string>();
+	}
+	if ( vm.count("obstimes") ){
+		observation_times = parse_times(vm["obstimes"].as<string>(), "obstimes");
+	}
+	if ( vm.count("outputlog") ){
+		output_per_decade = vm["outputlog"].as<double>();
+		if ( output_per_decade <= 0. ){
+			throw po::error("--outputlog should be positive");
+		}
+	}
+	if ( vm.count("outputevery") ){
+		output_every = vm["outputevery"].as<int>();
+		if ( output_every < 0 ){
+			throw po::error("--outputevery should be non-negative");
+		}
+	} else if ( not output_times.empty() or output_per_decade > 0. ){
+		output_every = 0;
+	}
+
+	Mx = vm["Mx"].as<double>() * GSL_CONST_CGSM_SOLAR_MASS;
+	kerr = vm["kerr"].as<double>();
+	alpha = vm["alpha"].as<double>();
+	Mopt = vm["Mopt"].as<double>() * GSL_CONST_CGSM_SOLAR_MASS;
+	P = vm["period"].as<double>() * DAY;
+	inclination = vm["inclination"].as<double>();
+	if ( not vm["rout"].defaulted() ){
+		r_out = vm["rout"].as<double>() * solar_radius;
+	} else{
+		r_out = r_out_func( Mx, Mopt, P );
+	}
+	if ( vm.count("rin") ){
+		r_in = vm["rin"].as<double>() * 3. * 2. * GSL_CONST_CGSM_GRAVITATIONAL_CONSTANT * Mx / (GSL_CONST_CGSM_SPEED_OF_LIGHT * GSL_CONST_CGSM_SPEED_OF_LIGHT);
+	} else{
+		r_in = r_in_func( Mx, kerr );
+	}
+
+	opacity_type = vm["opacity"].as<string>();
+	if ( vm.count("opacitytable") ){
+		opacity_table_filename = vm["opacitytable"].as<string>();
+	}
+	if ( opacity_type == "table" and opacity_table_filename.empty() ){
+		throw po::error("--opacity=table requires --opacitytable");
+	}
+	bound_cond_type = vm["boundcond"].as<string>();
+	T_min_hot_disk = vm["Thot"].as<double>();
+	F0 = vm["F0"].as<double>();
+	Mdot0 = vm["Mdot0"].as<double>();
+	initial_cond_shape = vm["initialcond"].as<string>();
+	power_order = vm["powerorder"].as<double>();
+
+	C_irr_input = vm["Cirr"].as<double>();
+	irr_factor_type = vm["irrfactortype"].as<string>();
+	fc = vm["dilution"].as<double>();
+	nu_min = vm["numin"].as<double>() * keV;
+	nu_max = vm["numax"].as<double>() * keV;
+	band_table_size = vm["bandtable"].as<int>();
+	band_table_Nnu = vm["bandtablenu"].as<int>();
+
+	Distance = vm["distance"].as<double>() * kpc;
+	if ( vm.count("filters") ){
+		filters_filename = vm["filters"].as<string>();
+	}
+
+	Time = vm["time"].as<double>() * DAY;
+	tau = vm["tau"].as<double>() * DAY;
+	adaptive_tau = vm.count("adaptive");
+	tau_rtol = vm["rtol"].as<double>();
+	tau_min = vm["taumin"].as<double>() * DAY;
+	tau_max = vm["taumax"].as<double>() * DAY;
+	Nx = vm["Nx"].as<int>();
+	grid_scale = vm["gridscale"].as<string>();
+	remesh_fraction = vm["remesh"].as<double>();
+	if ( remesh_fraction < 0. or remesh_fraction >= 1. ){
+		throw po::error("--remesh should be in [0, 1)");
+	}
+	refine = vm["refine"].as<double>();
+	if ( refine < 0. ){
+		throw po::error("--refine should be non-negative");
+	}
+	nonlinear_solver = vm["solver"].as<string>();
+	time_scheme = vm["timescheme"].as<string>();
+	solver_threads = vm["solverthreads"].as<int>();
+	if ( solver_threads < 0 ){
+		throw po::error("--solverthreads should be non-negative");
+	}
+	parallel_threshold = vm["parallelthreshold"].as<int>();
+	if ( parallel_threshold < 0 ){
+		throw po::error("--parallelthreshold should be non-negative");
+	}
+
+	if ( C_irr_input <= 0. and bound_cond_type == "Tirr" ){
+		throw po::error("It is obvious to use nonpositive --Cirr with --boundcond=Tirr");
+	}
+}
@@ -0,0 +1,94 @@
+#ifndef _ARGUMENTS_HPP
+#define _ARGUMENTS_HPP
+
+
+#include <boost/program_options.hpp>
+#include <string>
+#include <vector>
+
+#include "gsl_const_cgsm.h"
+#include "orbit.hpp"
+
+
+const double DAY = 86400.;
+const double Angstrem = 1e-8;
+const double keV = 1000. * GSL_CONST_CGSM_ELECTRON_VOLT / GSL_CONST_CGSM_PLANCKS_CONSTANT_H;
+const double Jy = 1e-23;
+const double solar_radius = 6.955e10;
+const double kpc = 1000. * GSL_CONST_CGSM_PARSEC;
+
+
+// All parameters of the model in cgs units, see FreddiArguments::description() for details
+class FreddiArguments{
+public:
+	double alpha = 0.25;
+	double fc = 1.7;
+	double kerr = 0.;
+	double Mx = 10. * GSL_CONST_CGSM_SOLAR_MASS;
+	double Mopt = 1. * GSL_CONST_CGSM_SOLAR_MASS;
+	double P = 1. * DAY;
+	double inclination = 0.;  // degrees
+	double Distance = 10. * kpc;
+	std::string filters_filename = "";
+	std::string opacity_table_filename = "";
+	double r_in = r_in_func( Mx, kerr );
+	double r_out = r_out_func( Mx, Mopt, P );
+	double T_min_hot_disk = 0.;
+	double C_irr_input = 0.;
+	double mu = 0.62;
+	double nu_min = 1. * keV;
+	double nu_max = 12. * keV;
+	int band_table_size = 512;
+	int band_table_Nnu = 500;
+	int Nx = 1000;
+	std::string grid_scale = "log";
+	double remesh_fraction = 0.;
+	double refine = 0.;
+	double Time = 25. * DAY;
+	double tau = 0.25 * DAY;
+	bool adaptive_tau = false;
+	double tau_rtol = 1e-3;
+	double tau_min = 1e-6 * DAY;
+	double tau_max = 5. * DAY;
+	double eps = 1e-6;
+	std::string nonlinear_solver = "picard";
+	std::string time_scheme = "euler";
+	int solver_threads = 0;
+	int parallel_threshold = 100000;
+	std::string bound_cond_type = "Teff";
+	double F0 = 1e36;
+	double Mdot0 = 0.;
+	double sigma_for_F_gauss = 5.;
+	double r_gauss_cut_to_r_out = 0.01;
+	double power_order = 6.;
+	double kMdot_out = 2.;
+	std::string filename_prefix = "freddi";
+	std::string output_dir = ".";
+	bool output_fulldata = false;
+	std::string fulldata_format = "text";
+	int output_every = 1;
+	std::vector<double> output_times;
+	double output_per_decade = 0.;
+	std::vector<double> observation_times;
+	bool telemetry = false;
+	int checkpoint_every = 0;
+	std::string restart_filename = "";
+	std::string initial_cond_shape = "power";
+	std::string opacity_type = "Kramers";
+	std::string irr_factor_type = "const";
+	// Options which are not defaulted in vm as --name=value, they are written
+	// to checkpoints. Values are printed with full precision, so the same
+	// arguments are obtained when they are parsed again
+	std::vector<std::string> options;
+
+	FreddiArguments(){};
+	FreddiArguments(const boost::program_options::variables_map &vm);
+
+	static boost::program_options::options_description description();
+	// If vm has --restart then stores options from the checkpoint file into
+	// vm, options which are already in vm have priority
+	static void store_restart_options(boost::program_options::variables_map &vm);
+};
+
+
+#endif // _ARGUMENTS_HPP
@@ -0,0 +1,210 @@
+#include "batched_diffusion.hpp"
+
+#include "simd_math.hpp"
+
+
+// Loops over points have inner loops over lanes, which are vectorised.
+// Points outside of the lane grid are excluded by selects instead of
+// branches, formulas are the same as in NonlinearDiffusion::nonuniform_1_2,
+// so results don't depend on the lane
+
+
+void BatchedNonlinearDiffusion::prepare(const int B, const int *N_lane, const double *tau, const double *right_bounder_cond, const vecd &x){
+	int N = 0;
+	for ( int l = 0; l < B; ++l ){
+		N = N_lane[l] > N ? N_lane[l] : N;
+	}
+	if ( N != this->N or B != this->B ){
+		this->N = N;
+		this->B = B;
+		for ( auto v : {&a, &b, &frac, &W, &f, &K_0, &K_1, &CC, &alpha, &beta} ){
+			v->resize(N * B);
+		}
+		for ( auto v : {&last, &frac_last, &f_last, &K_last, &right, &active, &copy_CC, &dif, &dif_CC, &residual, &delta} ){
+			v->resize(B);
+		}
+		iterations.resize(B);
+		flag.resize(B);
+		failed.resize(B);
+	}
+	for ( int l = 0; l < B; ++l ){
+		const int n = N_lane[l] - 1;
+		last[l] = n;
+		frac_last[l] = ( x[n*B + l] - x[(n-1)*B + l] ) * ( x[n*B + l] - x[(n-1)*B + l] ) * 0.5 / tau[l];
+		right[l] = ( x[n*B + l] - x[(n-1)*B + l] ) * right_bounder_cond[l];
+		active[l] = 1.;
+		iterations[l] = 0;
+		flag[l] = failed[l] = false;
+	}
+	for ( int i = 1; i < N-1; ++i ){
+		for ( int l = 0; l < B; ++l ){
+			const int k = i*B + l;
+			const bool inside = i < last[l];
+			a[k] = inside ? 2. * ( x[k+B] - x[k] ) / ( x[k+B] - x[k-B] ) : 0.;
+			b[k] = inside ? 2. * ( x[k] - x[k-B] ) / ( x[k+B] - x[k-B] ) : 0.;
+			frac[k] = inside ? ( x[k+B] - x[k] ) * ( x[k] - x[k-B] ) / tau[l] : 0.;
+		}
+	}
+}
+
+
+FREDDI_TARGET_CLONES
+void BatchedNonlinearDiffusion::start(const double *eps, const double *w0, const vecd &y){
+	const int size = N * B;
+	for ( int l = 0; l < B; ++l ){
+		const int k = static_cast<int>(last[l])*B + l;
+		f_last[l] = frac_last[l] * w0[k];
+		K_last[l] = frac_last[l] * W[k] / y[k];
+	}
+	const double * __restrict fr = frac.data();
+	const double * __restrict w = W.data();
+	const double * __restrict yy = y.data();
+	double * __restrict ff = f.data();
+	double * __restrict k0 = K_0.data();
+	double * __restrict k1 = K_1.data();
+	double * __restrict cc = CC.data();
+	const double * __restrict limit = last.data();
+	for ( int k = B; k < size - B; k += B ){
+		const double i = k / B;
+		#pragma omp simd
+		for ( int l = 0; l < B; ++l ){
+			const bool inside = i < limit[l];
+			ff[k+l] = inside ? fr[k+l] * w0[k+l] : 0.;
+			k1[k+l] = inside ? fr[k+l] * w[k+l] / yy[k+l] : 0.;
+			cc[k+l] = k0[k+l] = k1[k+l] * (1. + 2.*eps[l]);
+		}
+	}
+}
+
+
+FREDDI_TARGET_CLONES
+void BatchedNonlinearDiffusion::sweep(const double *left_bounder_cond, vecd &y){
+	const int size = N * B;
+	const double * __restrict aa = a.data();
+	const double * __restrict bb = b.data();
+	const double * __restrict ff = f.data();
+	const double * __restrict K = K_0.data();
+	double * __restrict al = alpha.data();
+	double * __restrict be = beta.data();
+	double * __restrict yy = y.data();
+	for ( int l = 0; l < B; ++l ){
+		al[B + l] = 0.;
+		be[B + l] = left_bounder_cond[l];
+	}
+	for ( int k = B; k < size - B; k += B ){
+		#pragma omp simd
+		for ( int l = 0; l < B; ++l ){
+			double c = 2. + K[k+l];
+			al[k+B+l] = bb[k+l] / ( c - al[k+l] * aa[k+l] );
+			be[k+B+l] = ( be[k+l] * aa[k+l] + ff[k+l] ) / ( c - al[k+l] * aa[k+l] );
+		}
+	}
+	// Points i < limit[l] are changed, it is zero for inactive lanes
+	double * __restrict limit = dif.data();
+	for ( int l = 0; l < B; ++l ){
+		limit[l] = 0.;
+		if ( active[l] != 0. ){
+			const int k = static_cast<int>(last[l])*B + l;
+			yy[k] = ( right[l] + f_last[l] + be[k] ) / ( 1. + K_last[l] - al[k] );
+			yy[l] = left_bounder_cond[l];
+			limit[l] = last[l];
+		}
+	}
+	for ( int k = size - 2*B; k > 0; k -= B ){
+		const double i = k / B;
+		#pragma omp simd
+		for ( int l = 0; l < B; ++l ){
+			const double y_new = al[k+B+l] * yy[k+B+l] + be[k+B+l];
+			yy[k+l] = i < limit[l] ? y_new : yy[k+l];
+		}
+	}
+}
+
+
+FREDDI_TARGET_CLONES
+void BatchedNonlinearDiffusion::update_K(const vecd &y){
+	const int size = N * B;
+	const double * __restrict fr = frac.data();
+	const double * __restrict w = W.data();
+	const double * __restrict yy = y.data();
+	const double * __restrict limit = last.data();
+	double * __restrict K = K_1.data();
+	for ( int k = B; k < size - B; k += B ){
+		const double i = k / B;
+		#pragma omp simd
+		for ( int l = 0; l < B; ++l ){
+			K[k+l] = i < limit[l] ? fr[k+l] * w[k+l] / yy[k+l] : 0.;
+		}
+	}
+}
+
+
+FREDDI_TARGET_CLONES
+void BatchedNonlinearDiffusion::differences(){
+	const int size = N * B;
+	const double * __restrict k0 = K_0.data();
+	const double * __restrict k1 = K_1.data();
+	const double * __restrict cc = CC.data();
+	const double * __restrict limit = last.data();
+	double * __restrict d = dif.data();
+	double * __restrict d_CC = dif_CC.data();
+	for ( int l = 0; l < B; ++l ){
+		d[l] = d_CC[l] = 0.;
+	}
+	for ( int k = B; k < size - B; k += B ){
+		const double i = k / B;
+		#pragma omp simd
+		for ( int l = 0; l < B; ++l ){
+			const double x = fabs( ( k1[k+l] - k0[k+l] ) / k1[k+l] );
+			const double x_CC = fabs( ( k1[k+l] - cc[k+l] ) / k1[k+l] );
+			d[l] = i < limit[l] and x > d[l] ? x : d[l];
+			d_CC[l] = i < limit[l] and x_CC > d_CC[l] ? x_CC : d_CC[l];
+		}
+	}
+}
+
+
+// Order of operations is the same as in nonuniform_1_2: iteration of a lane
+// is followed by update of CC, delta and flag, then the lane is checked for
+// convergence and divergence
+bool BatchedNonlinearDiffusion::check(const double *eps){
+	differences();
+	bool any_active = false;
+	for ( int l = 0; l < B; ++l ){
+		if ( active[l] == 0. ){
+			continue;
+		}
+		if ( iterations[l] % 4 == 1 ){
+			delta[l] = dif[l];
+		}
+		if ( iterations[l] % 4 == 3 and dif[l] >= delta[l] ){
+			flag[l] = true;
+		}
+		residual[l] = dif[l];
+		if ( not ( residual[l] > eps[l] ) ){
+			active[l] = 0.;
+		} else if ( dif_CC[l] > 0. and not flag[l] ){
+			any_active = true;
+		} else{
+			active[l] = 0.;
+			failed[l] = true;
+		}
+	}
+	return any_active;
+}
+
+
+void BatchedNonlinearDiffusion::count(){
+	const int size = N * B;
+	for ( int l = 0; l < B; ++l ){
+		if ( active[l] != 0. ){
+			++iterations[l];
+		}
+		copy_CC[l] = active[l] != 0. and iterations[l] % 2 == 0 ? 1. : 0.;
+	}
+	for ( int k = B; k < size - B; k += B ){
+		for ( int l = 0; l < B; ++l ){
+			CC[k+l] = copy_CC[l] != 0. ? K_0[k+l] : CC[k+l];
+		}
+	}
+}
@@ -0,0 +1,104 @@
+#ifndef _BATCHED_DIFFUSION_HPP
+#define _BATCHED_DIFFUSION_HPP
+
+
+#include <vector>
+
+#include "nonlinear_diffusion.hpp"
+
+
+// Solver of the same problem as NonlinearDiffusion::nonuniform_1_2 for B
+// independent systems advanced together, e.g. models of a parameter sweep.
+// Arrays are in structure of arrays layout: value at point i of system l
+// (lane) is [i*B + l], so sweeps over i process all lanes by SIMD
+// instructions. Lanes have their own time steps, boundary conditions, grids
+// and numbers of points N[l], arrays have N*B values for N = max N[l]. Values
+// at points i >= N[l] are ignored, but they should be finite and positive,
+// e.g. copies of the last point. Every lane iterates until its own
+// convergence, converged and diverged lanes keep their y while the others
+// continue, so the result of a lane is exactly the same as of nonuniform_1_2
+// for its system alone
+class BatchedNonlinearDiffusion{
+private:
+	int B = 0;
+	int N = 0; // max N_x+1
+	vecd a, b, frac, W, f, K_0, K_1, CC, alpha, beta;
+	// Values for every lane, the number of the last point is double to be
+	// compared with point numbers in SIMD loops
+	vecd last, frac_last, f_last, K_last, right, active, copy_CC, dif, dif_CC;
+	vecd residual, delta;
+	std::vector<int> iterations;
+	std::vector<char> flag, failed;
+
+	void prepare(int B, const int *N_lane, const double *tau, const double *right_bounder_cond, const vecd &x);
+	void start(const double *eps, const double *w0, const vecd &y);
+	// Solution of the tridiagonal system with coefficients K_0 and the other
+	// ones prepared by start() for active lanes, other lanes keep their y
+	void sweep(const double *left_bounder_cond, vecd &y);
+	void update_K(const vecd &y);
+	// max_dif_rel of K_1 and K_0, and of K_1 and CC for every lane
+	void differences();
+	// Decisions of nonuniform_1_2 about every active lane before the next
+	// iteration, returns false if there are no active lanes
+	bool check(const double *eps);
+	// Bookkeeping of nonuniform_1_2 after the iteration
+	void count();
+
+public:
+	// Number of iterations, relative difference between the last two
+	// iterations and divergence heuristic of lane l for the last call, see
+	// NonlinearDiffusion
+	int last_iterations(int l) const { return iterations[l]; }
+	double last_residual(int l) const { return residual[l]; }
+	bool last_divergence_heuristic(int l) const { return flag[l]; }
+	// Whether the solution of lane l failed, NonlinearDiffusion throws
+	// std::runtime_error in this case
+	bool last_failed(int l) const { return failed[l]; }
+
+	// Parameters are the same as of NonlinearDiffusion::nonuniform_1_2,
+	// but there are B values of tau, eps and boundary conditions. Wunc is called
+	// for the whole range of points of all lanes, so it should calculate w
+	// of every element of the arrays independently, like power-law wunc
+	// with GridFactors::W in the same layout
+	template <typename Wunc>
+	void nonuniform_1_2 (const int B, // number of lanes
+						 const int *N, // numbers of points N_x+1 of lanes
+						 const double *tau,
+						 const double *eps, // reletive error for w
+						 const double *left_bounder_cond, // y(left_border,Time+tau) = left_bounder_cond
+						 const double *right_bounder_cond, // \frac{y(right_border,Time+tau)}{dx} = right_bounder_cond
+						 const Wunc &wunc,
+						 const vecd &x, // array with (non)uniform grids
+						 vecd &y, // array with initial coundition and for results
+						 const double *w_start = nullptr // w at the start of the step, w(x, y) if it is null
+						);
+};
+
+
+template <typename Wunc>
+void BatchedNonlinearDiffusion::nonuniform_1_2 (const int B,
+												const int *N,
+												const double *tau,
+												const double *eps,
+												const double *left_bounder_cond,
+												const double *right_bounder_cond,
+												const Wunc &wunc,
+												const vecd &x,
+												vecd &y,
+												const double *w_start
+												){
+	prepare(B, N, tau, right_bounder_cond, x);
+	const int size = this->N * B;
+	wunc(x.data(), y.data(), W.data(), B, size-1);
+	start(eps, w_start != nullptr ? w_start : W.data(), y);
+	while ( check(eps) ){
+		K_0.swap(K_1);
+		sweep(left_bounder_cond, y);
+		wunc(x.data(), y.data(), W.data(), B, size-1);
+		update_K(y);
+		count();
+	}
+}
+
+
+#endif // _BATCHED_DIFFUSION_HPP
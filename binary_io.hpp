@@ -0,0 +1,40 @@
+#ifndef _BINARY_IO_HPP
+#define _BINARY_IO_HPP
+
+
+#include <cstdint>
+#include <cstring>	// std::memcpy
+#include <vector>
+
+
+// Little-endian encoding of uint64 and float64 used by binary output files
+
+inline void put(std::vector<char> &buffer, const uint64_t x){
+	for ( int i = 0; i < 8; ++i ){
+		buffer.push_back( static_cast<char>( (x >> (8*i)) & 0xff ) );
+	}
+}
+
+inline void put(std::vector<char> &buffer, const double x){
+	uint64_t i;
+	std::memcpy(&i, &x, sizeof(i));
+	put(buffer, i);
+}
+
+inline uint64_t get_uint64(const char *p){
+	uint64_t x = 0;
+	for ( int i = 0; i < 8; ++i ){
+		x |= static_cast<uint64_t>( static_cast<unsigned char>(p[i]) ) << (8*i);
+	}
+	return x;
+}
+
+inline double get_double(const char *p){
+	const uint64_t i = get_uint64(p);
+	double x;
+	std::memcpy(&x, &i, sizeof(x));
+	return x;
+}
+
+
+#endif // _BINARY_IO_HPP
@@ -0,0 +1,123 @@
+#include "checkpoint.hpp"
+
+#include <algorithm>
+#include <cstdio>	// std::rename
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include "binary_io.hpp"
+
+
+using namespace std;
+
+
+const char checkpoint_magic[] = "FREDDICP";
+const uint64_t checkpoint_version = 2;
+
+
+void write_checkpoint(const string &filename, const Checkpoint &c){
+	vector<char> buffer(checkpoint_magic, checkpoint_magic + 8);
+	put(buffer, checkpoint_version);
+	put(buffer, static_cast<uint64_t>(c.options.size()));
+	for ( const auto &option : c.options ){
+		put(buffer, static_cast<uint64_t>(option.size()));
+		buffer.insert(buffer.end(), option.begin(), option.end());
+	}
+	put(buffer, c.t);
+	put(buffer, c.tau);
+	put(buffer, c.tau_next);
+	put(buffer, static_cast<uint64_t>(c.i_t));
+	put(buffer, static_cast<uint64_t>(c.Nx));
+	put(buffer, c.Mdot_in);
+	put(buffer, c.Mdot_in_prev);
+	put(buffer, c.Mdot_out);
+	for ( const auto v : {&c.h, &c.F} ){
+		put(buffer, static_cast<uint64_t>(v->size()));
+		for ( const double x : *v ){
+			put(buffer, x);
+		}
+	}
+	put(buffer, c.tau_before);
+	put(buffer, static_cast<uint64_t>(c.F_before.size()));
+	for ( const double x : c.F_before ){
+		put(buffer, x);
+	}
+
+	const string tmp_filename = filename + ".tmp";
+	{
+		ofstream output(tmp_filename, ios::binary);
+		output.write(buffer.data(), buffer.size());
+		if ( not output ){
+			throw invalid_argument("Cannot write checkpoint file " + tmp_filename);
+		}
+	}
+	if ( rename(tmp_filename.c_str(), filename.c_str()) != 0 ){
+		throw invalid_argument("Cannot rename " + tmp_filename + " to " + filename);
+	}
+}
+
+
+Checkpoint read_checkpoint(const string &filename){
+	ifstream input(filename, ios::binary);
+	if ( not input ){
+		throw invalid_argument("Cannot open checkpoint file " + filename);
+	}
+	const vector<char> buffer( (istreambuf_iterator<char>(input)), istreambuf_iterator<char>() );
+
+	size_t position = 0;
+	auto need = [&](const uint64_t size){
+		if ( size > buffer.size() - position ){
+			throw invalid_argument(filename + " is truncated");
+		}
+	};
+	auto next_uint64 = [&]() -> uint64_t{
+		need(8);
+		position += 8;
+		return get_uint64(buffer.data() + position - 8);
+	};
+	auto next_double = [&]() -> double{
+		need(8);
+		position += 8;
+		return get_double(buffer.data() + position - 8);
+	};
+
+	need(16);
+	const uint64_t version = get_uint64(buffer.data() + 8);
+	if ( not equal(checkpoint_magic, checkpoint_magic + 8, buffer.begin()) or version < 1 or version > checkpoint_version ){
+		throw invalid_argument(filename + " is not a checkpoint file");
+	}
+	position = 16;
+
+	Checkpoint c;
+	const uint64_t options = next_uint64();
+	for ( uint64_t i = 0; i < options; ++i ){
+		const uint64_t size = next_uint64();
+		need(size);
+		c.options.emplace_back(buffer.data() + position, size);
+		position += size;
+	}
+	c.t = next_double();
+	c.tau = next_double();
+	c.tau_next = next_double();
+	c.i_t = static_cast<int>( next_uint64() );
+	c.Nx = static_cast<int>( next_uint64() );
+	c.Mdot_in = next_double();
+	c.Mdot_in_prev = next_double();
+	c.Mdot_out = next_double();
+	auto next_array = [&](vector<double> &v){
+		const uint64_t size = next_uint64();
+		need(8 * size);
+		v.resize(size);
+		for ( auto &x : v ){
+			x = next_double();
+		}
+	};
+	next_array(c.h);
+	next_array(c.F);
+	if ( version >= 2 ){
+		c.tau_before = next_double();
+		next_array(c.F_before);
+	}
+	return c;
+}
@@ -0,0 +1,35 @@
+#ifndef _CHECKPOINT_HPP
+#define _CHECKPOINT_HPP
+
+
+#include <string>
+#include <vector>
+
+
+// Evolving state of FreddiEvolution and options it was created with. File
+// format is: magic "FREDDICP", format version (2), number of options and
+// options as length and characters, then t, tau, tau_next, i_t, Nx, Mdot_in,
+// Mdot_in_prev, Mdot_out, size and values of h, size and values of F,
+// tau_before, size and values of F_before. All integers are uint64, all reals
+// are float64, both are little-endian. Version 1 files have no tau_before and
+// F_before and are still read
+struct Checkpoint{
+	// Non-default options as --name=value, see FreddiArguments::options
+	std::vector<std::string> options;
+	double t, tau, tau_next;
+	int i_t, Nx;
+	double Mdot_in, Mdot_in_prev, Mdot_out;
+	std::vector<double> h, F;
+	// History of --timescheme=bdf2, F_before is empty for implicit Euler
+	double tau_before = 0.;
+	std::vector<double> F_before;
+};
+
+
+// File is written under temporary name and then renamed, so the previous
+// checkpoint survives if the process is killed while writing
+void write_checkpoint(const std::string &filename, const Checkpoint &checkpoint);
+Checkpoint read_checkpoint(const std::string &filename);
+
+
+#endif // _CHECKPOINT_HPP
@@ -0,0 +1,101 @@
+#include "disc_modes.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+
+using namespace std;
+
+
+void SinusGaussF::initialize(FreddiEvolution &freddi){
+	const FreddiArguments &args = freddi.args;
+	const vecd &h = freddi.h;
+	const double h_in = freddi.h_in, h_out = freddi.h_out;
+	const double F0 = args.F0;
+
+	const double F0_sinus = 1e-6 * F0;
+	const double h_cut_for_F_gauss = h_out / sqrt(args.r_gauss_cut_to_r_out);
+	const double F_gauss_cut = F0 * exp( - (h_cut_for_F_gauss-h_out)*(h_cut_for_F_gauss-h_out) / (2. * h_out*h_out/(args.sigma_for_F_gauss*args.sigma_for_F_gauss)) );
+	for ( int i = 0; i < freddi.Nx; ++i ){
+		double F_gauss = F0 * exp( - (h.at(i)-h_out)*(h.at(i)-h_out) / (2. * h_out*h_out/(args.sigma_for_F_gauss*args.sigma_for_F_gauss)) ) - F_gauss_cut;
+		F_gauss = F_gauss >= 0 ? F_gauss : 0.;
+		const double F_sinus =  F0_sinus * sin( (h.at(i) - h_in) / (h_out - h_in) * M_PI / 2. );
+		freddi.F.at(i) = F_gauss + F_sinus;
+	}
+}
+
+
+void PowerF::initialize(FreddiEvolution &freddi){
+	const vecd &h = freddi.h;
+	const double h_in = freddi.h_in, h_out = freddi.h_out;
+	if ( freddi.Mdot_in != 0. ){
+		throw invalid_argument("It is obvious to use --Mdot with --initialcond=powerF");
+	}
+	for ( int i = 0; i < freddi.Nx; ++i ){
+		freddi.F.at(i) = freddi.args.F0 * pow( (h.at(i) - h_in) / (h_out - h_in), freddi.args.power_order );
+	}
+}
+
+
+void PowerSigma::initialize(FreddiEvolution &freddi){
+	const vecd &h = freddi.h;
+	const double h_in = freddi.h_in, h_out = freddi.h_out;
+	const OpacityRelated &oprel = freddi.oprel;
+	if ( freddi.Mdot_in != 0. ){
+		throw invalid_argument("It is obvious to use --Mdot with --initialcond=powerSigma");
+	}
+	for ( int i = 0; i < freddi.Nx; ++i ){
+		const double Sigma_to_Sigmaout = pow( (h.at(i) - h_in) / (h_out - h_in), freddi.args.power_order );
+		freddi.F.at(i) = freddi.args.F0 * pow( h.at(i) / h_out, (3. - oprel.n) / (1. - oprel.m) ) * pow( Sigma_to_Sigmaout, 1. / (1. - oprel.m) );
+	}
+}
+
+
+void SinusF::initialize(FreddiEvolution &freddi){
+	const vecd &h = freddi.h;
+	const double h_in = freddi.h_in, h_out = freddi.h_out;
+	double F0 = freddi.args.F0;
+	if ( freddi.Mdot_in > 0. ){
+		F0 = freddi.Mdot_in * (h_out - h_in) * 2./M_PI;
+	}
+	for ( int i = 0; i < freddi.Nx; ++i ){
+		freddi.F.at(i) = F0 * sin( (h.at(i) - h_in) / (h_out - h_in) * M_PI / 2. );
+	}
+}
+
+
+void SinusParabolaF::initialize(FreddiEvolution &freddi){
+	const FreddiArguments &args = freddi.args;
+	const vecd &h = freddi.h;
+	const int Nx = freddi.Nx;
+	const double h_in = freddi.h_in, h_out = freddi.h_out;
+	const double h_F0 = h_out * 0.9;
+	const double delta_h = h_out - h_F0;
+
+	const double F0 = 1.24e13 * pow(freddi.Sigma_hot_disk(freddi.R.at(Nx-1)), 10./7.) * pow(h.at(Nx-1), 22./7.) * pow(freddi.GM, -10./7.) * pow(args.alpha, 8./7.);
+
+	freddi.Mdot_out = -args.kMdot_out * F0 / (h_F0 - h_in) * M_PI*M_PI;
+
+	for ( int i = 0; i < Nx; ++i ){
+		if ( h.at(i) < h_F0 ){
+			freddi.F.at(i) = F0 * sin( (h.at(i) - h_in) / (h_F0 - h_in) * M_PI / 2. );
+		} else{
+			freddi.F.at(i) = F0 * ( 1. - args.kMdot_out / (h_F0-h_in) / delta_h * M_PI / 4. * (h.at(i) - h_F0)*(h.at(i) - h_F0) );
+		}
+	}
+}
+
+
+void QuasistatF::initialize(FreddiEvolution &freddi){
+	const vecd &h = freddi.h;
+	const double h_in = freddi.h_in, h_out = freddi.h_out;
+	const OpacityRelated &oprel = freddi.oprel;
+	double F0 = freddi.args.F0;
+	if ( freddi.Mdot_in > 0. ){
+		F0 = freddi.Mdot_in * (h_out - h_in) / h_out * h_in / oprel.f_F(h_in/h_out);
+	}
+	for ( int i = 0; i < freddi.Nx; ++i ){
+		const double xi_LS2000 = h.at(i) / h_out;
+		freddi.F.at(i) = F0 * oprel.f_F(xi_LS2000) * (1. - h_in / h.at(i)) / (1. - h_in / h_out);
+	}
+}
@@ -0,0 +1,112 @@
+#ifndef _DISC_MODES_HPP
+#define _DISC_MODES_HPP
+
+
+#include <string>
+
+#include "freddi_evolution.hpp"
+#include "mode_list.hpp"
+
+
+// Modes of FreddiEvolution selected by --irrfactortype, --boundcond and
+// --initialcond. New mode is a type with has_name() and the static functions
+// of its kind, which is appended to the corresponding list
+
+
+// Irradiation factor: Qirr = C_irr eta Mdot_in c^2 / (4 pi R^2)
+struct ConstIrradiation{
+	static bool has_name(const std::string &name){ return name == "const"; }
+	static double C_irr(const double C_irr_input, const double Height, const double R){
+		return C_irr_input;
+	}
+};
+
+struct SquareIrradiation{
+	static bool has_name(const std::string &name){ return name == "square"; }
+	static double C_irr(const double C_irr_input, const double Height, const double R){
+		return C_irr_input * (Height / R) * (Height / R);
+	}
+};
+
+typedef ModeList<ConstIrradiation, SquareIrradiation> IrradiationModes;
+
+
+// Outer boundary: prepare() is called after every step, then the boundary
+// moves inside to the outermost point i for which cold(i) is false
+struct MdotOutBoundary{
+	static bool has_name(const std::string &name){ return name == "MdotOut"; }
+	static void prepare(FreddiEvolution &freddi){
+		freddi.Mdot_out = - freddi.args.kMdot_out * freddi.Mdot_in;
+	}
+	static bool cold(const FreddiEvolution &freddi, const int i){
+		return freddi.Sigma.at(i) < freddi.Sigma_hot_disk(freddi.R.at(i));
+	}
+};
+
+struct FourSigmaCritBoundary{
+	static bool has_name(const std::string &name){ return name == "fourSigmaCrit"; }
+	static void prepare(FreddiEvolution &freddi){}
+	// Equation from Menou et al. 1999. Factor 4 is from their fig 8 and connected to point where Mdot = 0.
+	static bool cold(const FreddiEvolution &freddi, const int i){
+		return freddi.Sigma.at(i) < 4. * freddi.Sigma_hot_disk(freddi.R.at(i));
+	}
+};
+
+struct TeffBoundary{
+	static bool has_name(const std::string &name){ return name == "Teff"; }
+	static void prepare(FreddiEvolution &freddi){}
+	static bool cold(const FreddiEvolution &freddi, const int i){
+		return freddi.Tph.at(i) < freddi.args.T_min_hot_disk;
+	}
+};
+
+struct TirrBoundary{
+	static bool has_name(const std::string &name){ return name == "Tirr"; }
+	static void prepare(FreddiEvolution &freddi){}
+	static bool cold(const FreddiEvolution &freddi, const int i){
+		if ( freddi.Tph_boundary_on_rise and freddi.Mdot_in >= freddi.Mdot_in_prev ){
+			return freddi.Tph.at(i) < freddi.args.T_min_hot_disk;
+		}
+		return freddi.Tirr.at(i) < freddi.args.T_min_hot_disk;
+	}
+};
+
+typedef ModeList<MdotOutBoundary, FourSigmaCritBoundary, TeffBoundary, TirrBoundary> BoundaryModes;
+
+
+// Initial condition: initialize() sets F and can set Mdot_out, it is called
+// once by the constructor of FreddiEvolution
+struct SinusGaussF{
+	static bool has_name(const std::string &name){ return name == "sinusgauss"; }
+	static void initialize(FreddiEvolution &freddi);
+};
+
+struct PowerF{
+	static bool has_name(const std::string &name){ return name == "power" or name == "powerF"; }
+	static void initialize(FreddiEvolution &freddi);
+};
+
+struct PowerSigma{
+	static bool has_name(const std::string &name){ return name == "powerSigma"; }
+	static void initialize(FreddiEvolution &freddi);
+};
+
+struct SinusF{
+	static bool has_name(const std::string &name){ return name == "sinus" or name == "sinusF"; }
+	static void initialize(FreddiEvolution &freddi);
+};
+
+struct SinusParabolaF{
+	static bool has_name(const std::string &name){ return name == "sinusparabola"; }
+	static void initialize(FreddiEvolution &freddi);
+};
+
+struct QuasistatF{
+	static bool has_name(const std::string &name){ return name == "quasistat"; }
+	static void initialize(FreddiEvolution &freddi);
+};
+
+typedef ModeList<SinusGaussF, PowerF, PowerSigma, SinusF, SinusParabolaF, QuasistatF> InitialConditionModes;
+
+
+#endif // _DISC_MODES_HPP
@@ -0,0 +1,107 @@
+#include "freddi_batch.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+using namespace std;
+
+
+bool FreddiBatch::supports(const FreddiArguments &args){
+	return not args.adaptive_tau and args.nonlinear_solver == "picard" and args.time_scheme == "euler"
+			and ( args.opacity_type == "Kramers" or args.opacity_type == "OPAL" );
+}
+
+
+FreddiBatch::FreddiBatch(const vector<FreddiEvolution *> &models):
+	models(models),
+	errors(models.size())
+{
+	for ( auto freddi : models ){
+		if ( not supports(freddi->args) ){
+			throw invalid_argument("FreddiBatch doesn't support options of the model");
+		}
+		if ( freddi->oprel.type != models.front()->oprel.type ){
+			throw invalid_argument("Models of FreddiBatch should have the same opacity law");
+		}
+	}
+}
+
+
+template <typename Exponents>
+void FreddiBatch::solve(){
+	const PowerLawWunc<Exponents> wunc(models[lanes.front()]->oprel, W_factor.data());
+	solver.nonuniform_1_2(lanes.size(), N.data(), tau.data(), eps.data(), left.data(), right.data(), wunc, h, F);
+}
+
+
+vector<size_t> FreddiBatch::step(){
+	lanes.clear();
+	for ( size_t i = 0; i < models.size(); ++i ){
+		if ( errors[i].empty() and models[i]->can_step(models[i]->args.Time) ){
+			lanes.push_back(i);
+		}
+	}
+	if ( lanes.empty() ){
+		return lanes;
+	}
+
+	const int B = lanes.size();
+	for ( auto v : {&tau, &eps, &left, &right} ){
+		v->resize(B);
+	}
+	N.resize(B);
+	int N_max = 0;
+	for ( int l = 0; l < B; ++l ){
+		FreddiEvolution &freddi = *models[lanes[l]];
+		freddi.begin_step();
+		freddi.t += freddi.args.tau;
+		N[l] = freddi.Nx;
+		N_max = max(N_max, freddi.Nx);
+		tau[l] = freddi.args.tau;
+		eps[l] = freddi.args.eps;
+		left[l] = 0.;
+		right[l] = freddi.Mdot_out;
+	}
+	for ( auto v : {&h, &F, &W_factor} ){
+		v->resize(N_max * B);
+	}
+	for ( int l = 0; l < B; ++l ){
+		const FreddiEvolution &freddi = *models[lanes[l]];
+		for ( int i = 0; i < N_max; ++i ){
+			const int k = min(i, freddi.Nx - 1);
+			h[i*B + l] = freddi.h[k];
+			F[i*B + l] = freddi.F[k];
+			W_factor[i*B + l] = freddi.grid_factors.W[k];
+		}
+	}
+
+	if ( models.front()->oprel.type == "Kramers" ){
+		solve<KramersExponents>();
+	} else{
+		solve<OpalExponents>();
+	}
+
+	vector<size_t> stepped;
+	for ( int l = 0; l < B; ++l ){
+		FreddiEvolution &freddi = *models[lanes[l]];
+		for ( int i = 0; i < freddi.Nx; ++i ){
+			freddi.F[i] = F[i*B + l];
+		}
+		freddi.Niter += solver.last_iterations(l);
+		freddi.telemetry.residual = solver.last_residual(l);
+		freddi.telemetry.divergence_heuristic = solver.last_divergence_heuristic(l) or solver.last_failed(l);
+		try{
+			if ( solver.last_failed(l) ){
+				throw runtime_error("Divergence in nonlinear_diffusion");
+			}
+			freddi.calculate_W();
+			freddi.finish_step();
+		} catch (runtime_error &er){
+			errors[lanes[l]] = er.what();
+			continue;
+		}
+		stepped.push_back(lanes[l]);
+	}
+	return stepped;
+}
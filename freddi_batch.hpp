@@ -0,0 +1,52 @@
+#ifndef _FREDDI_BATCH_HPP
+#define _FREDDI_BATCH_HPP
+
+
+#include <string>
+#include <vector>
+
+#include "batched_diffusion.hpp"
+#include "freddi_evolution.hpp"
+
+
+// Models advanced together in lockstep, implicit time steps of all of them are
+// solved by one BatchedNonlinearDiffusion call with a model per SIMD lane.
+// Models can have different parameters, grids and time steps, the result of
+// every model is exactly the same as of FreddiEvolution::step() for the model
+// alone. Telemetry wall times are not measured. Models are not owned by the
+// object
+class FreddiBatch{
+private:
+	std::vector<FreddiEvolution *> models;
+	std::vector<std::string> errors;
+	BatchedNonlinearDiffusion solver;
+	// Models of the current step and their data in the layout of
+	// BatchedNonlinearDiffusion, points after the outer boundary of a model
+	// are copies of the boundary point
+	std::vector<size_t> lanes;
+	std::vector<int> N;
+	vecd tau, eps, left, right;
+	vecd h, F, W_factor;
+
+	template <typename Exponents> void solve();
+
+public:
+	// Whether the model can be computed in a batch: it should have constant
+	// time step, implicit Euler scheme, simple iterations and Kramers or
+	// OPAL opacity
+	static bool supports(const FreddiArguments &args);
+
+	// All models should be supported and have the same opacity law
+	explicit FreddiBatch(const std::vector<FreddiEvolution *> &models);
+
+	// Compute the next step of every model which can_step(args.Time) and has
+	// no error, returns numbers of models which made the step, it is empty
+	// if all models are finished
+	std::vector<size_t> step();
+	// Message of std::runtime_error thrown by the step of i-th model, the
+	// model isn't computed after it
+	const std::string &error(size_t i) const { return errors[i]; }
+};
+
+
+#endif // _FREDDI_BATCH_HPP
@@ -0,0 +1,419 @@
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "arguments.hpp"
+#include "freddi_evolution.hpp"
+#include "nonlinear_diffusion.hpp"
+#include "opacity_table.hpp"
+#include "spectrum.hpp"
+#include "wunc.hpp"
+
+
+namespace po = boost::program_options;
+using namespace std;
+
+
+struct BenchResult{
+	string name;
+	int N;
+	double seconds;
+};
+
+
+// Prevents the compiler from removing benchmarked calls
+static volatile double sink;
+
+
+// The best of three mean times of one call, every mean is over min_time/3
+template <typename Function>
+static double seconds_per_call(const Function &function, const double min_time){
+	double best = INFINITY;
+	for ( int repeat = 0; repeat < 3; ++repeat ){
+		const auto start = chrono::steady_clock::now();
+		double elapsed;
+		int calls = 0;
+		do{
+			function();
+			++calls;
+			elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		} while ( elapsed < min_time / 3. );
+		best = fmin( best, elapsed / calls );
+	}
+	return best;
+}
+
+
+// Rosseland opacity table of OPAL power law varkappa = 1.5e20 rho T^-5/2
+static RosselandOpacityTable opal_opacity_table(){
+	vector<double> log_T, log_R, log_kappa;
+	for ( int i = 0; i <= 100; ++i ){
+		log_T.push_back(3.5 + 0.05 * i);
+	}
+	for ( int i = 0; i <= 18; ++i ){
+		log_R.push_back(-8. + 0.5 * i);
+	}
+	for ( const double lg_T : log_T ){
+		for ( const double lg_R : log_R ){
+			log_kappa.push_back(log10(1.5e20) + lg_R + 3. * (lg_T - 6.) - 2.5 * lg_T);
+		}
+	}
+	return RosselandOpacityTable(log_T, log_R, log_kappa);
+}
+
+
+// Kernels of one time step on the grid of N points. The disk state is
+// obtained by one step of FreddiEvolution from quasi-stationary initial
+// condition
+static void micro_benchmarks(const int N, const double min_time, vector<BenchResult> &results){
+	FreddiArguments args;
+	args.Nx = N;
+	args.initial_cond_shape = "quasistat";
+	args.Mdot0 = 1e18;
+	FreddiEvolution freddi(args);
+	freddi.step();
+	const vecd h(freddi.h.begin(), freddi.h.begin() + freddi.Nx);
+	const vecd F(freddi.F.begin(), freddi.F.begin() + freddi.Nx);
+	const vecd R(freddi.R.begin(), freddi.R.begin() + freddi.Nx);
+	vecd Tph(freddi.Tph.begin(), freddi.Tph.begin() + freddi.Nx);
+	Tph[0] = Tph[1];
+	const PowerLawWunc<KramersExponents> wunc(freddi.oprel);
+	vecd y;
+
+	const OpacityRelated opal("OPAL", args.Mx, args.alpha, args.mu);
+	OpacityRelated table("OPAL", args.Mx, args.alpha, args.mu);
+	table.structure = make_shared<VerticalStructureTable>(opal_opacity_table(), table.GM, table.alpha, table.mu, table.Pi1, table.Pi2, table.Pi3, table.Pi4);
+	vecd structure_row;
+	for ( const double h_i : h ){
+		structure_row.push_back(table.structure->row(h_i));
+	}
+	const PowerLawWunc<OpalExponents> opal_wunc(opal);
+	const TabulatedWunc table_wunc(table, structure_row.data());
+	vecd W(N);
+
+	results.push_back({ "PowerLawWunc<OpalExponents>", N, seconds_per_call([&](){
+		opal_wunc(h.data(), F.data(), W.data(), 1, N-1);
+		sink = W.back();
+	}, min_time) });
+
+	results.push_back({ "TabulatedWunc", N, seconds_per_call([&](){
+		table_wunc(h.data(), F.data(), W.data(), 1, N-1);
+		sink = W.back();
+	}, min_time) });
+
+	results.push_back({ "nonlenear_diffusion_nonuniform_1_2", N, seconds_per_call([&](){
+		y = F;
+		nonlenear_diffusion_nonuniform_1_2(args.tau, args.eps, 0., 0., wunc, h, y);
+		sink = y.back();
+	}, min_time) });
+
+	NonlinearDiffusion solver;
+	results.push_back({ "NonlinearDiffusion::nonuniform_1_2", N, seconds_per_call([&](){
+		y = F;
+		solver.nonuniform_1_2(args.tau, args.eps, 0., 0., wunc, h, y);
+		sink = y.back();
+	}, min_time) });
+
+	results.push_back({ "NonlinearDiffusion::nonuniform_1_2_newton", N, seconds_per_call([&](){
+		y = F;
+		solver.nonuniform_1_2_newton(args.tau, args.eps, 0., 0., wunc, h, y);
+		sink = y.back();
+	}, min_time) });
+
+	if ( args.parallel_threshold > 0 and N >= args.parallel_threshold ){
+		NonlinearDiffusion parallel_solver;
+		parallel_solver.set_threads(0, args.parallel_threshold);
+		const ParallelWunc<decltype(wunc)> parallel_wunc(wunc, parallel_solver);
+		results.push_back({ "NonlinearDiffusion::nonuniform_1_2 parallel", N, seconds_per_call([&](){
+			y = F;
+			parallel_solver.nonuniform_1_2(args.tau, args.eps, 0., 0., parallel_wunc, h, y);
+			sink = y.back();
+		}, min_time) });
+	}
+
+	RadialSpectrum spectrum;
+	const BandEmissivity band(args.nu_min, args.nu_max, args.band_table_size, args.band_table_Nnu);
+	results.push_back({ "Luminosity_table", N, seconds_per_call([&](){
+		spectrum.set(R, Tph);
+		sink = spectrum.Luminosity(band);
+	}, min_time) });
+
+	results.push_back({ "Luminosity_direct", N, seconds_per_call([&](){
+		spectrum.set(R, Tph);
+		sink = spectrum.Luminosity(args.nu_min, args.nu_max, 100);
+	}, min_time) });
+
+	results.push_back({ "I_lambda", N, seconds_per_call([&](){
+		spectrum.set(R, Tph);
+		sink = spectrum.I_lambda(5500. * Angstrem);
+	}, min_time) });
+
+	results.push_back({ "T_GR", N, seconds_per_call([&](){
+		double sum = 0.;
+		for ( int i = 1; i < N; ++i ){
+			sum += T_GR(R[i], args.kerr, args.Mx, args.Mdot0, R[0]);
+		}
+		sink = sum;
+	}, min_time) });
+
+	results.push_back({ "OpacityRelated::Height", N, seconds_per_call([&](){
+		double sum = 0.;
+		for ( int i = 1; i < N; ++i ){
+			sum += freddi.oprel.Height(R[i], F[i]);
+		}
+		sink = sum;
+	}, min_time) });
+}
+
+
+// Whole calculation with default parameters
+static void evolution_benchmarks(const double min_time, vector<BenchResult> &results){
+	const RosselandOpacityTable opacity = opal_opacity_table();
+	{
+		FreddiArguments args;
+		const OpacityRelated oprel("OPAL", args.Mx, args.alpha, args.mu);
+		results.push_back({ "setup/VerticalStructureTable", 1, seconds_per_call([&](){
+			const VerticalStructureTable table(opacity, oprel.GM, oprel.alpha, oprel.mu, oprel.Pi1, oprel.Pi2, oprel.Pi3, oprel.Pi4);
+			sink = table.W(0., 1e36);
+		}, min_time) });
+	}
+
+	for ( const string initial_cond : {"powerF", "sinusF", "quasistat"} ){
+		for ( const string opacity : {"Kramers", "OPAL"} ){
+			FreddiArguments args;
+			args.initial_cond_shape = initial_cond;
+			args.opacity_type = opacity;
+			results.push_back({ "evolution/" + initial_cond + "/" + opacity, args.Nx, seconds_per_call([&](){
+				FreddiEvolution freddi(args);
+				sink = freddi.run_until(args.Time).back().Mdot_in;
+			}, min_time) });
+		}
+	}
+}
+
+
+// w = y^(3/10) like for Kramers opacity, where W ~ F^(1-m) with m = 3/10
+struct ConvergenceWunc{
+	void operator()(const double *x, const double *y, double *w, const int first, const int last) const{
+		for ( int i = first; i <= last; ++i ){
+			w[i] = pow(y[i], 0.3);
+		}
+	}
+	void derivative(const double *x, const double *y, const double *w, double *dw, const int first, const int last) const{
+		for ( int i = first; i <= last; ++i ){
+			dw[i] = 0.3 * w[i] / y[i];
+		}
+	}
+};
+
+
+// Solution of dw/dt = y'' on [0, 1] at t = 0.05 by n_steps steps of
+// NonlinearDiffusion, variant is "1_2" (y(0) = 0, y'(1) = 0) or "2_2"
+// (y'(0) = y'(1) = 0). The first one is solved by Newton method, because
+// simple iterations of nonuniform_1_2 keep the coefficient of the outer
+// boundary equation from the start of the step, which gives error ~ dx^2
+// every step
+static vecd diffusion_solution(const string &variant, const bool bdf2, const int n_steps){
+	const int N = 201;
+	const double tau = 0.05 / n_steps;
+	const ConvergenceWunc wunc;
+	vecd x(N), y(N), y_before, w(N), w_before(N);
+	for ( int i = 0; i < N; ++i ){
+		x[i] = i / (N - 1.);
+		y[i] = variant == "1_2" ? sin(0.5 * M_PI * x[i]) : 1. + 0.5 * cos(M_PI * x[i]);
+	}
+	NonlinearDiffusion solver;
+	for ( int step = 0; step < n_steps; ++step ){
+		double tau_euler = tau;
+		const double *w_start = nullptr;
+		if ( not y_before.empty() ){
+			wunc(x.data(), y.data(), w.data(), 1, N-1);
+			wunc(x.data(), y_before.data(), w_before.data(), 1, N-1);
+			tau_euler = bdf2_start(tau, tau, w.data(), w_before.data(), w_before.data(), 1, N-1);
+			w_start = w_before.data();
+		}
+		const vecd y_start = y;
+		if ( variant == "1_2" ){
+			solver.nonuniform_1_2_newton(tau_euler, 1e-12, 0., 0., wunc, x, y, w_start);
+		} else{
+			solver.nonuniform_2_2(tau_euler, 1e-12, 0., 0., wunc, x, y, w_start);
+		}
+		if ( bdf2 ){
+			y_before = y_start;
+		}
+	}
+	return y;
+}
+
+
+// Mdot_in at t = 20 days computed by n_steps steps of FreddiEvolution with
+// fixed outer radius. Initial condition corresponds to t = -tau, so the
+// calculation is stopped at 20 days - tau. The result is {Mdot_in, Mdot_in},
+// so it is compared in the same way as diffusion_solution()
+static vecd evolution_solution(const bool bdf2, const int n_steps){
+	FreddiArguments args;
+	args.Nx = 300;
+	args.initial_cond_shape = "quasistat";
+	args.Mdot0 = 1e19;
+	args.T_min_hot_disk = 0.;
+	args.nonlinear_solver = "newton";
+	args.time_scheme = bdf2 ? "bdf2" : "euler";
+	args.tau = 20. * DAY / n_steps;
+	args.Time = 20. * DAY - args.tau;
+	FreddiEvolution freddi(args);
+	while ( freddi.can_step(args.Time) ){
+		freddi.step();
+	}
+	return vecd(2, freddi.Mdot_in);
+}
+
+
+// Maximum relative error of the solution for the halved time step, the
+// reference is BDF2 solution with 1024 steps. Order is log2 of the ratio of
+// consecutive errors, it should be close to 1 for implicit Euler method and
+// to 2 for BDF2, otherwise the function returns false
+static bool convergence_test(){
+	bool passed = true;
+	cout << left << setw(24) << "solver" << setw(8) << "scheme" << right << setw(8) << "steps" << setw(14) << "error" << setw(8) << "order" << endl;
+	for ( const string variant : {"1_2", "2_2", "evolution"} ){
+		auto solution = [&](const bool bdf2, const int n_steps){
+			return variant == "evolution" ? evolution_solution(bdf2, n_steps) : diffusion_solution(variant, bdf2, n_steps);
+		};
+		const vecd reference = solution(true, 1024);
+		for ( const bool bdf2 : {false, true} ){
+			double error_prev = NAN;
+			double order = NAN;
+			for ( int n_steps = 4; n_steps <= 64; n_steps *= 2 ){
+				const double error = max_dif_rel(reference, solution(bdf2, n_steps), 1, reference.size() - 1);
+				order = log2(error_prev / error);
+				cout << left << setw(24) << ( variant == "1_2" ? "nonuniform_1_2_newton" : variant == "2_2" ? "nonuniform_2_2" : "FreddiEvolution" ) << setw(8) << ( bdf2 ? "bdf2" : "euler" ) << right << setw(8) << n_steps << setw(14) << setprecision(4) << error;
+				if ( std::isfinite(order) ){
+					cout << setw(8) << setprecision(3) << order;
+				}
+				cout << endl;
+				error_prev = error;
+			}
+			passed = passed and fabs( order - (bdf2 ? 2. : 1.) ) < 0.2;
+		}
+	}
+	return passed;
+}
+
+
+static void write_json(ostream &output, const vector<BenchResult> &results){
+	output << "{\n  \"benchmarks\": [\n";
+	for ( size_t i = 0; i < results.size(); ++i ){
+		output << "    {\"name\": \"" << results[i].name << "\", \"N\": " << results[i].N << ", \"seconds\": " << setprecision(6) << results[i].seconds << "}";
+		output << ( i + 1 < results.size() ? ",\n" : "\n" );
+	}
+	output << "  ]\n}\n";
+}
+
+
+// Reads files written by write_json(), every benchmark is on its own line
+static map<string, double> read_json(const string &filename){
+	ifstream input(filename);
+	if ( not input ){
+		throw invalid_argument("Cannot open baseline file " + filename);
+	}
+	const regex record("\"name\": \"([^\"]*)\", \"N\": ([0-9]+), \"seconds\": ([^}]+)\\}");
+	map<string, double> seconds;
+	string line;
+	while ( getline(input, line) ){
+		smatch match;
+		if ( regex_search(line, match, record) ){
+			seconds[match[1].str() + "/N=" + match[2].str()] = stod(match[3].str());
+		}
+	}
+	return seconds;
+}
+
+
+int main(int ac, char *av[]){
+	po::options_description desc("Freddi bench - benchmarks of numerical kernels and of whole calculations. Results are written as JSON and are compared with the baseline, slowdown larger than --tolerance is an error");
+	desc.add_options()
+		( "help,h", "Produce help message" )
+		( "output,o", po::value<string>()->default_value("bench.json"), "JSON file for results" )
+		( "baseline", po::value<string>(), "JSON file with results to compare with, e.g. previous output of freddi-bench" )
+		( "tolerance", po::value<double>()->default_value(0.25), "Maximum allowed relative slowdown compared with baseline" )
+		( "mintime", po::value<double>()->default_value(0.3), "Minimum time of every benchmark, seconds" )
+		( "maxNx", po::value<int>()->default_value(1000000), "Largest grid size of kernel benchmarks, grid sizes are powers of ten starting from 100" )
+		( "convergence", "Instead of benchmarks, print errors of time integration schemes of NonlinearDiffusion for decreasing time step and their observed order. It is an error if the order differs from the theoretical one by more than 0.2" )
+	;
+	po::variables_map vm;
+	try {
+		po::store( po::parse_command_line(ac, av, desc), vm );
+		if ( vm.count("help") ){
+			cout << desc << endl;
+			return 0;
+		}
+		po::notify(vm);
+	} catch (exception &e){
+		cerr << "Error: " << e.what() << endl;
+		return 1;
+	}
+
+	if ( vm.count("convergence") ){
+		if ( not convergence_test() ){
+			cerr << "Error: observed order of time integration differs from the theoretical one" << endl;
+			return 1;
+		}
+		return 0;
+	}
+
+	try {
+		map<string, double> baseline;
+		if ( vm.count("baseline") ){
+			baseline = read_json(vm["baseline"].as<string>());
+		}
+		const double tolerance = vm["tolerance"].as<double>();
+		const double min_time = vm["mintime"].as<double>();
+
+		vector<BenchResult> results;
+		for ( int N = 100; N <= vm["maxNx"].as<int>(); N *= 10 ){
+			micro_benchmarks(N, min_time, results);
+		}
+		evolution_benchmarks(min_time, results);
+
+		ofstream output(vm["output"].as<string>());
+		write_json(output, results);
+
+		int regressions = 0;
+		for ( const auto &result : results ){
+			const string key = result.name + "/N=" + to_string(result.N);
+			cout << left << setw(56) << key << right << setw(14) << setprecision(4) << result.seconds << " s";
+			if ( result.name.find('/') == string::npos ){
+				cout << setw(10) << setprecision(3) << result.seconds / result.N * 1e9 << " ns/point";
+			} else{
+				cout << setw(19) << "";
+			}
+			const auto it = baseline.find(key);
+			if ( it != baseline.end() ){
+				const double ratio = result.seconds / it->second;
+				cout << setw(9) << setprecision(3) << ratio << " x baseline";
+				if ( ratio > 1. + tolerance ){
+					cout << "  REGRESSION";
+					++regressions;
+				}
+			}
+			cout << endl;
+		}
+		if ( regressions > 0 ){
+			cerr << "Error: " << regressions << " benchmarks are slower than baseline by more than " << tolerance * 100. << "%" << endl;
+			return 1;
+		}
+	} catch (exception &e){
+		cerr << "Error: " << e.what() << endl;
+		return 1;
+	}
+
+	return 0;
+}
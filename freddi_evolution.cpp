@@ -0,0 +1,631 @@
+#include "freddi_evolution.hpp"
+
+#include <algorithm>
+
+#include "disc_modes.hpp"
+#include "orbit.hpp"
+
+
+using namespace std;
+
+
+FreddiEvolution::FreddiEvolution(const FreddiArguments &args, shared_ptr<const BandEmissivity> shared_band_X):
+	T_GR_profile(args.kerr, args.Mx),
+	band_X(shared_band_X),
+	tau_next(args.tau),
+	observables_ready(false),
+	t_prev(-args.tau),
+	i_observation(0),
+	irradiation_mode(mode_index(IrradiationModes(), args.irr_factor_type)),
+	boundary_mode(mode_index(BoundaryModes(), args.bound_cond_type)),
+	initial_condition_mode(mode_index(InitialConditionModes(), args.initial_cond_shape)),
+	bdf2(args.time_scheme == "bdf2"),
+	tau_before(0.),
+	args(args),
+	oprel(args.opacity_type, args.Mx, args.alpha, args.mu, args.opacity_table_filename),
+	photometry( args.filters_filename.empty() ? Photometry() : Photometry(args.filters_filename) ),
+	GM(GSL_CONST_CGSM_GRAVITATIONAL_CONSTANT * args.Mx),
+	eta(efficiency_of_accretion(args.kerr)),
+	h_in(sqrt( GSL_CONST_CGSM_GRAVITATIONAL_CONSTANT * args.Mx * args.r_in )),
+	h_out(sqrt( GSL_CONST_CGSM_GRAVITATIONAL_CONSTANT * args.Mx * args.r_out )),
+	cosiOverD2(cos( args.inclination / 180 * M_PI ) / args.Distance / args.Distance),
+	Tph_boundary_on_rise(args.initial_cond_shape == "power" or args.initial_cond_shape == "sinusgauss"),
+	Nx(args.Nx),
+	h(Nx), R(Nx), F(Nx),
+	Mdot_in(args.Mdot0), Mdot_in_prev(0.), Mdot_out(0.),
+	t(-args.tau), tau(args.tau), i_t(-1),
+	C_irr(0.),
+	Lx(0.), Mdisk(0.),
+	m(photometry.bands.size(), 0.),
+	Niter(0)
+{
+	if ( args.nonlinear_solver != "picard" and args.nonlinear_solver != "newton" ){
+		throw invalid_argument(args.nonlinear_solver);
+	}
+	if ( args.time_scheme != "euler" and args.time_scheme != "bdf2" ){
+		throw invalid_argument(args.time_scheme);
+	}
+
+	solver.set_threads(args.solver_threads, args.parallel_threshold);
+	uniform_grid(h_out);
+	grid_factors.set(h, R, GM, oprel);
+
+	if ( args.band_table_size > 0 and not band_X ){
+		band_X = make_shared<BandEmissivity>(args.nu_min, args.nu_max, args.band_table_size, args.band_table_Nnu);
+	}
+
+	initialize_F();
+	// Initial condition is a function of h, so it is calculated again on
+	// the refined grid instead of interpolation
+	if ( args.refine > 0. ){
+		refined_grid(vecd(h), vecd(F));
+		grid_factors.set(h, R, GM, oprel);
+		initialize_F();
+	}
+	if ( not args.restart_filename.empty() ){
+		restore(read_checkpoint(args.restart_filename));
+	}
+}
+
+
+void FreddiEvolution::solve(const double tau, const vecd &F_before, const double tau_before){
+	if ( oprel.type == "Kramers" ){
+		solve(PowerLawWunc<KramersExponents>(oprel, grid_factors.W.data()), tau, F_before, tau_before);
+	} else if ( oprel.type == "OPAL" ){
+		solve(PowerLawWunc<OpalExponents>(oprel, grid_factors.W.data()), tau, F_before, tau_before);
+	} else if ( oprel.structure ){
+		solve(TabulatedWunc(oprel, grid_factors.structure_row.data()), tau, F_before, tau_before);
+	} else{
+		solve(RuntimePowerLawWunc(oprel, grid_factors.W.data()), tau, F_before, tau_before);
+	}
+}
+
+
+template <typename Wunc>
+void FreddiEvolution::solve(const Wunc &wunc, const double tau, const vecd &F_before, const double tau_before){
+	// W of large grids is calculated by the threads of the solver
+	if ( solver.threaded() ){
+		solve_timed(ParallelWunc<Wunc>(wunc, solver), tau, F_before, tau_before);
+	} else{
+		solve_timed(wunc, tau, F_before, tau_before);
+	}
+}
+
+
+template <typename Wunc>
+void FreddiEvolution::solve_timed(const Wunc &wunc, const double tau, const vecd &F_before, const double tau_before){
+	if ( args.telemetry ){
+		ScopedTimer timer(&telemetry.solve);
+		solve_nonlinear(TimedWunc<Wunc>(wunc, telemetry.wunc), tau, F_before, tau_before);
+	} else{
+		solve_nonlinear(wunc, tau, F_before, tau_before);
+	}
+}
+
+
+template <typename Wunc>
+void FreddiEvolution::solve_nonlinear(const Wunc &wunc, const double tau, const vecd &F_before, const double tau_before){
+	// BDF2 step is solved as implicit Euler step of other length from other W
+	double tau_euler = tau;
+	const double *W_start = nullptr;
+	if ( not F_before.empty() ){
+		W_before.resize(Nx);
+		wunc(h.data(), F.data(), W.data(), 1, Nx-1);
+		wunc(h.data(), F_before.data(), W_before.data(), 1, Nx-1);
+		tau_euler = bdf2_start(tau, tau_before, W.data(), W_before.data(), W_before.data(), 1, Nx-1);
+		W_start = W_before.data();
+	}
+	try{
+		if ( args.nonlinear_solver == "newton" ){
+			solver.nonuniform_1_2_newton(tau_euler, args.eps, 0., Mdot_out, wunc, h, F, W_start);
+		} else{
+			solver.nonuniform_1_2(tau_euler, args.eps, 0., Mdot_out, wunc, h, F, W_start);
+		}
+	} catch (runtime_error &){
+		Niter += solver.last_iterations();
+		telemetry.residual = solver.last_residual();
+		telemetry.divergence_heuristic = true;
+		throw;
+	}
+	Niter += solver.last_iterations();
+	telemetry.residual = solver.last_residual();
+	telemetry.divergence_heuristic = telemetry.divergence_heuristic or solver.last_divergence_heuristic();
+	wunc(h.data(), F.data(), W.data(), 1, Nx-1);
+}
+
+
+void FreddiEvolution::calculate_W(){
+	if ( oprel.type == "Kramers" ){
+		const PowerLawWunc<KramersExponents> wunc(oprel, grid_factors.W.data());
+		wunc(h.data(), F.data(), W.data(), 1, Nx-1);
+	} else if ( oprel.type == "OPAL" ){
+		const PowerLawWunc<OpalExponents> wunc(oprel, grid_factors.W.data());
+		wunc(h.data(), F.data(), W.data(), 1, Nx-1);
+	} else if ( oprel.structure ){
+		const TabulatedWunc wunc(oprel, grid_factors.structure_row.data());
+		wunc(h.data(), F.data(), W.data(), 1, Nx-1);
+	} else{
+		const RuntimePowerLawWunc wunc(oprel, grid_factors.W.data());
+		wunc(h.data(), F.data(), W.data(), 1, Nx-1);
+	}
+}
+
+
+// Step doubling: the step is computed once with tau and twice with tau/2, the
+// difference of the results estimates local error of the second solution,
+// which is accepted if the error is less than args.tau_rtol. Implicit Euler
+// method has local error ~ tau^2, so the next step is changed by factor
+// sqrt(tau_rtol / error), BDF2 has local error ~ tau^3 and the factor is
+// cbrt(tau_rtol / error). BDF2 history of the accepted step is F_start and
+// tau_try, so the ratio of consecutive steps is not larger than max_factor,
+// which keeps BDF2 stable. Diverged attempts are repeated with smaller step
+void FreddiEvolution::step_adaptive(const double t_max){
+	const double safety = 0.9;
+	const double min_factor = 0.2;
+	const double max_factor = 2.;
+
+	F_start = F;
+	while ( true ){
+		const bool last = t + tau_next >= t_max;
+		const double tau_try = last ? t_max - t : tau_next;
+
+		double error = INFINITY;
+		try{
+			solve(tau_try, F_before, tau_before);
+			F_full = F;
+			F = F_start;
+			solve(0.5 * tau_try, F_before, tau_before);
+			solve(0.5 * tau_try, bdf2 ? F_start : F_before, 0.5 * tau_try);
+			error = max_dif_rel(F, F_full, 1, Nx-1);
+		} catch (runtime_error &){}
+
+		const double rate = bdf2 ? cbrt(args.tau_rtol / error) : sqrt(args.tau_rtol / error);
+		const double factor = error < INFINITY ? fmin( max_factor, fmax( min_factor, safety * rate ) ) : min_factor;
+		if ( error <= args.tau_rtol ){
+			t = last ? t_max : t + tau_try;
+			tau = tau_try;
+			if ( bdf2 ){
+				F_before.swap(F_start);
+				tau_before = tau_try;
+			}
+			if ( not last ){
+				tau_next = fmin( args.tau_max, tau_try * factor );
+			}
+			return;
+		}
+
+		F = F_start;
+		tau_next = tau_try * factor;
+		if ( tau_next < args.tau_min ){
+			throw runtime_error("Time step is less than minimal one");
+		}
+	}
+}
+
+
+void FreddiEvolution::uniform_grid(const double h_last){
+	for ( int i = 0; i < Nx; ++i ){
+		if ( args.grid_scale == "log" ){
+			h.at(i) = h_in * pow( h_last/h_in, i/(Nx-1.) );
+		} else if ( args.grid_scale == "linear" ){
+			h.at(i) = h_in + (h_last - h_in) * i/(Nx-1.);
+		} else{
+			throw invalid_argument(args.grid_scale);
+		}
+		R.at(i) = h.at(i) * h.at(i) / GM;
+	}
+}
+
+
+// Monotone piecewise cubic Hermite interpolation (Fritsch & Carlson 1980) of
+// y(x) given at the first N points to increasing x_new inside of [x_0, x_{N-1}]
+static void monotone_cubic(const vecd &x, const vecd &y, const int N, const vecd &x_new, vecd &y_new){
+	vecd slope(N);
+	slope[0] = ( y[1] - y[0] ) / ( x[1] - x[0] );
+	slope[N-1] = ( y[N-1] - y[N-2] ) / ( x[N-1] - x[N-2] );
+	for ( int k = 1; k < N-1; ++k ){
+		const double dx_left = x[k] - x[k-1], dx_right = x[k+1] - x[k];
+		const double left = ( y[k] - y[k-1] ) / dx_left, right = ( y[k+1] - y[k] ) / dx_right;
+		if ( left * right <= 0. ){
+			slope[k] = 0.;
+		} else{
+			const double w_left = 2. * dx_right + dx_left, w_right = dx_right + 2. * dx_left;
+			slope[k] = ( w_left + w_right ) / ( w_left / left + w_right / right );
+		}
+	}
+	int j = 0;
+	for ( size_t i = 0; i < x_new.size(); ++i ){
+		while ( j < N-2 and x[j+1] < x_new[i] ){
+			++j;
+		}
+		const double dx = x[j+1] - x[j];
+		const double s = ( x_new[i] - x[j] ) / dx;
+		y_new[i] = (1. + 2.*s) * (1. - s) * (1. - s) * y[j] + s * (1. - s) * (1. - s) * dx * slope[j]
+				+ s * s * (3. - 2.*s) * y[j+1] - s * s * (1. - s) * dx * slope[j+1];
+	}
+}
+
+
+void FreddiEvolution::refined_grid(const vecd &h_old, const vecd &F_old){
+	const int Nx_old = h_old.size();
+	const bool log_scale = args.grid_scale == "log";
+	vecd xi(Nx_old), C(Nx_old, 0.);
+	double var_F = 0.;
+	for ( int i = 0; i < Nx_old; ++i ){
+		xi[i] = log_scale ? log(h_old[i]) : h_old[i];
+		if ( i > 0 ){
+			var_F += fabs( F_old[i] - F_old[i-1] );
+		}
+	}
+	const double h_last = h_old[Nx_old-1];
+	for ( int i = 1; i < Nx_old; ++i ){
+		C[i] = C[i-1] + ( xi[i] - xi[i-1] ) / ( xi[Nx_old-1] - xi[0] );
+		C[i] += 0.5 * args.refine * ( pow(h_old[i] / h_last, 4.) - pow(h_old[i-1] / h_last, 4.) );
+		if ( var_F > 0. ){
+			C[i] += 0.5 * args.refine * fabs( F_old[i] - F_old[i-1] ) / var_F;
+		}
+	}
+	int j = 0;
+	for ( int k = 1; k < Nx-1; ++k ){
+		const double c = C[Nx_old-1] * k / (Nx - 1.);
+		while ( j < Nx_old-2 and C[j+1] < c ){
+			++j;
+		}
+		const double xi_k = xi[j] + ( xi[j+1] - xi[j] ) * ( c - C[j] ) / ( C[j+1] - C[j] );
+		h.at(k) = log_scale ? exp(xi_k) : xi_k;
+	}
+	h.at(0) = h_old[0];
+	h.at(Nx-1) = h_last;
+	for ( int i = 0; i < Nx; ++i ){
+		R.at(i) = h.at(i) * h.at(i) / GM;
+	}
+}
+
+
+// Grid is rebuilt at the start of the step, so radial arrays of the last
+// step stay consistent with h and R until then. BDF2 history is dropped,
+// the first step on the new grid is implicit Euler step
+void FreddiEvolution::remesh(){
+	auto current_mass = [this]() -> double{
+		W.assign(Nx, 0.);
+		calculate_W();
+		Sigma.assign(Nx, 0.);
+		for ( int i = 1; i < Nx; ++i ){
+			Sigma[i] = W[i] * grid_factors.Sigma[i];
+		}
+		return disk_mass();
+	};
+	const double mass = current_mass();
+
+	const int Nx_old = Nx;
+	const vecd h_old = h;
+	const vecd F_old(F.begin(), F.begin() + Nx_old);
+	Nx = args.Nx;
+	h.resize(Nx);
+	if ( args.refine > 0. ){
+		refined_grid(h_old, F_old);
+	} else{
+		uniform_grid(h_old[Nx_old-1]);
+	}
+	grid_factors.set(h, R, GM, oprel);
+
+	monotone_cubic(h_old, F_old, Nx_old, h, F);
+	F[0] = F_old[0];
+	F[Nx-1] = F_old[Nx_old-1];
+
+	// Interpolation changes the mass of the disc by ~ grid step^2, F is
+	// scaled back to the old mass, W ~ F^(1-m) gives the scale, few more
+	// iterations are needed for tabulated opacity
+	for ( int iteration = 0; iteration < 5; ++iteration ){
+		const double ratio = mass / current_mass();
+		if ( fabs(ratio - 1.) < 1e-12 ){
+			break;
+		}
+		const double scale = pow( ratio, 1. / (1. - oprel.m) );
+		for ( int i = 1; i < Nx; ++i ){
+			F[i] *= scale;
+		}
+	}
+	F_before.clear();
+}
+
+
+// Equation from Lasota, Dubus, Kruk A&A 2008, Menou et al. 1999. Sigma_cr is from their fig 8 and connected to point where Mdot is minimal.
+double FreddiEvolution::Sigma_hot_disk(double r) const{
+	return 39.9 * pow(args.alpha/0.1, -0.80) * pow(r/1e10, 1.11) * pow(args.Mx/GSL_CONST_CGSM_SOLAR_MASS, -0.37);
+}
+
+
+void FreddiEvolution::initialize_F(){
+	initialize_F(InitialConditionModes());
+}
+
+
+template <typename... InitialConditions>
+void FreddiEvolution::initialize_F(ModeList<InitialConditions...>){
+	static void (* const initializers[])(FreddiEvolution &) = { &InitialConditions::initialize... };
+	initializers[initial_condition_mode](*this);
+}
+
+
+void FreddiEvolution::restore(const Checkpoint &c){
+	if ( c.F.size() != F.size() or c.h.size() != static_cast<size_t>(c.Nx) or c.Nx > args.Nx or c.Nx < 2 ){
+		throw invalid_argument("Grid of checkpoint differs from --Nx");
+	}
+	Nx = c.Nx;
+	h = c.h;
+	for ( int i = 0; i < Nx; ++i ){
+		R.at(i) = h.at(i) * h.at(i) / GM;
+	}
+	grid_factors.set(h, R, GM, oprel);
+	F = c.F;
+	t = t_prev = c.t;
+	tau = c.tau;
+	tau_next = c.tau_next;
+	i_t = c.i_t;
+	Mdot_in = c.Mdot_in;
+	Mdot_in_prev = c.Mdot_in_prev;
+	Mdot_out = c.Mdot_out;
+	if ( c.F_before.size() != 0 and c.F_before.size() != F.size() ){
+		throw invalid_argument("Grid of checkpoint differs from --Nx");
+	}
+	// Checkpoint of implicit Euler calculation has no history, so BDF2
+	// continues from it by implicit Euler step
+	if ( bdf2 ){
+		F_before = c.F_before;
+		tau_before = c.tau_before;
+	}
+	const auto &times = args.observation_times;
+	i_observation = upper_bound(times.begin(), times.end(), t + 1e-6 * tau) - times.begin();
+}
+
+
+Checkpoint FreddiEvolution::checkpoint() const{
+	Checkpoint c;
+	c.options = args.options;
+	c.t = t;
+	c.tau = tau;
+	c.tau_next = tau_next;
+	c.i_t = i_t;
+	c.Nx = Nx;
+	c.Mdot_in = Mdot_in;
+	c.Mdot_in_prev = Mdot_in_prev;
+	c.Mdot_out = Mdot_out;
+	c.h = h;
+	c.F = F;
+	c.tau_before = tau_before;
+	c.F_before = F_before;
+	return c;
+}
+
+
+void FreddiEvolution::step(const double t_max){
+	begin_step();
+	if ( args.adaptive_tau ){
+		step_adaptive(t_max);
+	} else{
+		t += args.tau;
+		if ( bdf2 ){
+			F_start = F;
+		}
+		solve(args.tau, F_before, tau_before);
+		if ( bdf2 ){
+			F_before.swap(F_start);
+			tau_before = args.tau;
+		}
+	}
+	finish_step();
+}
+
+
+void FreddiEvolution::begin_step(){
+	if ( Nx < args.remesh_fraction * args.Nx ){
+		remesh();
+	}
+	W.assign(Nx, 0.);
+	Tph.assign(Nx, 0.);
+	Tph_vis.assign(Nx, 0.);
+	Tph_X.assign(Nx, 0.);
+	Tirr.assign(Nx, 0.);
+	Sigma.assign(Nx, 0.);
+	Height.assign(Nx, 0.);
+
+	observables_ready = false;
+	if ( not args.observation_times.empty() ){
+		F_prev = F;
+	}
+	t_prev = t;
+
+	Niter = 0;
+	telemetry = StepTelemetry();
+}
+
+
+void FreddiEvolution::finish_step(){
+	++i_t;
+
+	Mdot_in_prev = Mdot_in;
+	Mdot_in = ( F.at(1) - F.at(0) ) / ( h.at(1) - h.at(0) );
+
+	calculate_diagnostics();
+	move_outer_boundary();
+
+	observations.clear();
+	const auto &times = args.observation_times;
+	for ( ; i_observation < times.size() and times[i_observation] <= t + 1e-6 * tau; ++i_observation ){
+		if ( times[i_observation] >= t_prev ){
+			observations.push_back(observe(times[i_observation]));
+		}
+	}
+}
+
+
+// State at t_observation is linear interpolation of F between the last two
+// steps, it has the same accuracy as implicit Euler step itself
+FreddiSummary FreddiEvolution::observe(const double t_observation) const{
+	FreddiEvolution state(*this);
+	const double weight = fmin( 1., ( t_observation - t_prev ) / ( t - t_prev ) );
+	for ( size_t i = 0; i < F.size(); ++i ){
+		state.F[i] = F_prev[i] + weight * ( F[i] - F_prev[i] );
+	}
+	state.t = t_observation;
+	state.Mdot_in = ( state.F.at(1) - state.F.at(0) ) / ( h.at(1) - h.at(0) );
+	state.calculate_W();
+	state.calculate_diagnostics();
+	state.observables_ready = false;
+	state.calculate_observables();
+	return state.summary();
+}
+
+
+void FreddiEvolution::calculate_diagnostics(){
+	calculate_diagnostics(IrradiationModes());
+}
+
+
+template <typename... Irradiations>
+void FreddiEvolution::calculate_diagnostics(ModeList<Irradiations...>){
+	static void (FreddiEvolution::* const methods[])() = { &FreddiEvolution::calculate_diagnostics_with<Irradiations>... };
+	(this->*methods[irradiation_mode])();
+}
+
+
+template <typename Irradiation>
+void FreddiEvolution::calculate_diagnostics_with(){
+	if ( oprel.structure ){
+		oprel.structure->Height(grid_factors.structure_row.data(), F.data(), Height.data(), 1, Nx-1);
+	} else{
+		for ( int i = 1; i < Nx; ++i ){
+			Height.at(i) = grid_factors.Height[i] * pow(F.at(i), oprel.Height_exp_F);
+		}
+	}
+	const double Qx_coef = eta * Mdot_in;
+	for ( int i = 1; i < Nx; ++i ){
+		Sigma.at(i) = W.at(i) * grid_factors.Sigma[i];
+		Tph_vis.at(i) = grid_factors.Tph_vis[i] * pow(F.at(i), 0.25);
+
+		C_irr = Irradiation::C_irr(args.C_irr_input, Height.at(i), R.at(i));
+		const double Qx = C_irr * Qx_coef * grid_factors.Qx[i];
+		Tirr.at(i) = pow( Qx / GSL_CONST_CGSM_STEFAN_BOLTZMANN_CONSTANT, 0.25 );
+		Tph.at(i) = pow( pow(Tph_vis.at(i), 4.) + Qx / GSL_CONST_CGSM_STEFAN_BOLTZMANN_CONSTANT, 0.25 );
+	}
+}
+
+
+void FreddiEvolution::calculate_observables(){
+	if ( observables_ready ){
+		return;
+	}
+	observables_ready = true;
+
+	{
+		ScopedTimer timer(args.telemetry ? &telemetry.spectrum : nullptr);
+		// Radial arrays have the size of the grid before move_outer_boundary()
+		const int N = Tph_X.size();
+		const vecd &T_GR_factors = T_GR_profile.factors(R, N);
+		const double Mdot_in_quarter = pow(Mdot_in, 0.25);
+		for ( int i = 1; i < N; ++i ){
+			Tph_X.at(i) = args.fc * T_GR_factors[i] * Mdot_in_quarter;
+		}
+
+		spectrum.set(R, Tph_X);
+		if ( band_X ){
+			Lx = spectrum.Luminosity(*band_X) / pow(args.fc, 4.);
+		} else{
+			Lx = spectrum.Luminosity( args.nu_min, args.nu_max, 100 ) / pow(args.fc, 4.);
+		}
+	}
+	{
+		ScopedTimer timer(args.telemetry ? &telemetry.photometry : nullptr);
+		spectrum.set(R, Tph);
+		photometry.magnitudes(spectrum, cosiOverD2, m);
+	}
+
+	Mdisk = disk_mass();
+}
+
+
+double FreddiEvolution::disk_mass() const{
+	double mass = 0.;
+	for ( int i = 0; i < Nx; ++i ){
+		double stepR;
+		if ( i == 0              ) stepR = R.at(i+1) - R.at(i  );
+		if ( i == Nx-1           ) stepR = R.at(i  ) - R.at(i-1);
+		if ( i > 0 and i < Nx-1  ) stepR = R.at(i+1) - R.at(i-1);
+		mass += 0.5 * Sigma.at(i) * 2.*M_PI * R.at(i) * stepR;
+	}
+	return mass;
+}
+
+
+void FreddiEvolution::move_outer_boundary(){
+	move_outer_boundary(BoundaryModes());
+}
+
+
+template <typename... Boundaries>
+void FreddiEvolution::move_outer_boundary(ModeList<Boundaries...>){
+	static void (FreddiEvolution::* const methods[])() = { &FreddiEvolution::move_outer_boundary_with<Boundaries>... };
+	(this->*methods[boundary_mode])();
+}
+
+
+template <typename Boundary>
+void FreddiEvolution::move_outer_boundary_with(){
+	Boundary::prepare(*this);
+	int ii = Nx;
+	do{
+		ii--;
+	} while( Boundary::cold(*this, ii) );
+
+	if ( ii < Nx-1 ){
+		Nx = ii+1;
+		// F.at(Nx-2) = F.at(Nx-1) - Mdot_out / (2.*M_PI) * (h.at(Nx-1) - h.at(Nx-2));
+		h.resize(Nx);
+	}
+}
+
+
+bool FreddiEvolution::can_step(const double T) const{
+	if ( args.adaptive_tau ){
+		return t < T;
+	}
+	return t + args.tau <= T;
+}
+
+
+vector<FreddiSummary> FreddiEvolution::run_until(const double T){
+	vector<FreddiSummary> summaries;
+	while ( can_step(T) ){
+		step(T);
+		calculate_observables();
+		summaries.push_back(summary());
+	}
+	return summaries;
+}
+
+
+FreddiSummary FreddiEvolution::summary() const{
+	FreddiSummary s;
+	summary(s);
+	return s;
+}
+
+
+void FreddiEvolution::summary(FreddiSummary &s) const{
+	if ( not observables_ready ){
+		throw logic_error("calculate_observables() should be called before summary()");
+	}
+	s.t = t;
+	s.Mdot_in = Mdot_in;
+	s.Lx = Lx;
+	s.H2R = Height.at(Nx-1) / R.at(Nx-1);
+	s.Rhot = R.at(Nx-1);
+	s.Tphout = Tph.at(Nx-1);
+	s.Mdisk = Mdisk;
+	s.kxout = C_irr;
+	s.Qirr2Qvisout = pow( Tirr.at(Nx-1) / Tph_vis.at(Nx-1), 4. );
+	s.m = m;
+	s.Niter = Niter;
+	s.tau = tau;
+}
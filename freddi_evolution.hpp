@@ -0,0 +1,167 @@
+#ifndef _FREDDI_EVOLUTION_HPP
+#define _FREDDI_EVOLUTION_HPP
+
+
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "arguments.hpp"
+#include "checkpoint.hpp"
+#include "grid_factors.hpp"
+#include "mode_list.hpp"
+#include "nonlinear_diffusion.hpp"
+#include "opacity_related.hpp"
+#include "photometry.hpp"
+#include "spectrum.hpp"
+#include "telemetry.hpp"
+#include "wunc.hpp"
+
+
+// Global disk parameters for one time step, the same as the columns of PREFIX.dat
+struct FreddiSummary{
+	double t;
+	double Mdot_in, Lx, H2R, Rhot, Tphout, Mdisk, kxout, Qirr2Qvisout;
+	std::vector<double> m;
+	int Niter;
+	double tau;
+};
+
+
+// Evolution of the disk for one set of parameters. Object can be used to
+// compute many models in one process without option parsing and file output
+class FreddiEvolution{
+	friend class FreddiBatch;
+
+private:
+	NonlinearDiffusion solver;
+	RadialSpectrum spectrum;
+	TemperatureGRProfile T_GR_profile;
+	GridFactors grid_factors;
+	// Table for X-ray luminosity, it is null if args.band_table_size == 0
+	std::shared_ptr<const BandEmissivity> band_X;
+	// Used by adaptive time stepping only
+	vecd F_start, F_full;
+	double tau_next;
+	// Whether calculate_observables() was called after the last step
+	bool observables_ready;
+	// State before the last step and the first of args.observation_times
+	// which is not reached yet, used for interpolation to observation times
+	vecd F_prev;
+	double t_prev;
+	size_t i_observation;
+	// Whether --timescheme=bdf2, then F_before is the state one step before F
+	// and tau_before is the length of that step. F_before is empty before
+	// the first step and for implicit Euler method
+	bool bdf2;
+	vecd F_before, W_before;
+	double tau_before;
+	// Numbers of modes in IrradiationModes, BoundaryModes and
+	// InitialConditionModes of disc_modes.hpp
+	int irradiation_mode, boundary_mode, initial_condition_mode;
+
+	// Step of length tau from F, it is BDF2 step if F_before is not empty
+	void solve(double tau, const vecd &F_before, double tau_before);
+	template <typename Wunc> void solve(const Wunc &wunc, double tau, const vecd &F_before, double tau_before);
+	template <typename Wunc> void solve_timed(const Wunc &wunc, double tau, const vecd &F_before, double tau_before);
+	template <typename Wunc> void solve_nonlinear(const Wunc &wunc, double tau, const vecd &F_before, double tau_before);
+	// Parts of step() before and after the time step of F, FreddiBatch
+	// makes the time step itself
+	void begin_step();
+	void finish_step();
+	void step_adaptive(double t_max);
+	// Grids of the current size Nx: uniform in terms of args.grid_scale
+	// between h_in and h_last, or refined between the first and the last
+	// points of h_old for F_old given on it, see --refine
+	void uniform_grid(double h_last);
+	void refined_grid(const vecd &h_old, const vecd &F_old);
+	// New grid of args.Nx points between h_in and the current outer boundary,
+	// see --remesh and --refine
+	void remesh();
+	// Mass of the disc for the current Sigma
+	double disk_mass() const;
+	void initialize_F();
+	template <typename... InitialConditions> void initialize_F(ModeList<InitialConditions...>);
+	void restore(const Checkpoint &checkpoint);
+	void calculate_W();
+	void calculate_diagnostics();
+	template <typename... Irradiations> void calculate_diagnostics(ModeList<Irradiations...>);
+	template <typename Irradiation> void calculate_diagnostics_with();
+	FreddiSummary observe(double t_observation) const;
+	void move_outer_boundary();
+	template <typename... Boundaries> void move_outer_boundary(ModeList<Boundaries...>);
+	template <typename Boundary> void move_outer_boundary_with();
+
+public:
+	const FreddiArguments args;
+	const OpacityRelated oprel;
+	Photometry photometry;
+	const double GM, eta, h_in, h_out, cosiOverD2;
+	// With --boundcond=Tirr the outer radius is found from Tph instead of
+	// Tirr while Mdot_in grows, it is true for --initialcond=power and sinusgauss
+	const bool Tph_boundary_on_rise;
+
+	int Nx;
+	vecd h, R, F;
+	double Mdot_in, Mdot_in_prev, Mdot_out;
+	// Time of the last computed step. Initial condition corresponds to -tau,
+	// so the first step has t = 0
+	double t;
+	// Length of the last computed step, it differs from args.tau only for
+	// adaptive time stepping
+	double tau;
+	// Number of the last computed step, the first step has number 0
+	int i_t;
+
+	// Radial structure of the disk for the last computed step
+	vecd W, Sigma, Height, Tph, Tph_vis, Tirr;
+	double C_irr;
+	// Observables are not needed to compute the evolution and are calculated
+	// by calculate_observables() only
+	vecd Tph_X;
+	double Lx, Mdisk;
+	// Magnitudes in photometry.bands
+	vecd m;
+	// Number of solver iterations made by the last step, including rejected
+	// attempts of adaptive time stepping
+	int Niter;
+	// Solver statistics of the last step, wall times are measured only if
+	// args.telemetry is true
+	StepTelemetry telemetry;
+	// Global parameters at args.observation_times within the last step
+	std::vector<FreddiSummary> observations;
+
+	// Initial state is read from args.restart_filename if it isn't empty.
+	// shared_band_X is the X-ray band table of another model with the same band
+	// and table options, it is used instead of computing the table again
+	FreddiEvolution(const FreddiArguments &args, std::shared_ptr<const BandEmissivity> shared_band_X = nullptr);
+
+	// X-ray band table, it is null if args.band_table_size == 0
+	std::shared_ptr<const BandEmissivity> band_table() const { return band_X; }
+	// Compute next time step, can throw std::runtime_error if solver fails.
+	// Adaptive step is shortened to finish not later than t_max
+	void step(double t_max = INFINITY);
+	// Whether the next step finishes not later than T
+	bool can_step(double T) const;
+	// Calculate Tph_X, Lx, Mdisk and m for the last computed step. They are
+	// the most expensive part of the step when tau is small, so call it only
+	// for steps which are output
+	void calculate_observables();
+	// Compute steps while t <= T, returns global parameters for every step
+	std::vector<FreddiSummary> run_until(double T);
+	// Global parameters of the last step, calculate_observables() should be
+	// called before, otherwise std::logic_error is thrown
+	FreddiSummary summary() const;
+	// The same, but s can keep its buffers
+	void summary(FreddiSummary &s) const;
+	// State after the last step, calculation continued from it is the same
+	// as without interruption
+	Checkpoint checkpoint() const;
+	// Critical surface density of the hot disk at radius r
+	double Sigma_hot_disk(double r) const;
+};
+
+
+#endif // _FREDDI_EVOLUTION_HPP
@@ -0,0 +1,93 @@
+#include <boost/program_options.hpp>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "arguments.hpp"
+#include "light_curve_fit.hpp"
+
+
+namespace po = boost::program_options;
+using namespace std;
+
+
+int main(int ac, char *av[]){
+	po::options_description desc("Freddi fit - fit observed light curve by freddi models. Chi^2 of a column of PREFIX.dat is minimised over chosen options by Nelder-Mead method, models are computed in parallel. Best-fit values, their errors and covariance are printed. Values of fitted options are the initial guess, other options are the same for all models");
+	po::options_description fit("Fit options");
+	fit.add_options()
+		( "lightcurve", po::value<string>()->required(), "File with observed light curve: columns time (days), value and its error. Lines started with # are ignored" )
+		( "fitcolumn", po::value<string>()->default_value("Lx"), "Column of PREFIX.dat fitted to the light curve: Mdot, Lx, H2R, Rhot, Tphout, Mdisk, kxout, Qiir2Qvisout or magnitude like mV, in units of PREFIX.dat" )
+		( "fitparams", po::value<string>()->default_value("alpha,F0"), "Comma-separated names of fitted options, e.g. alpha,F0,Cirr,Thot. Options should have double values, their initial values should be non-zero. Parameters keep signs of their initial values" )
+		( "fitstep", po::value<double>()->default_value(0.1), "Relative size of the initial simplex for every parameter" )
+		( "fittol", po::value<double>()->default_value(1e-3), "Fit converges when chi^2 of the vertices of the simplex differ by less than this value" )
+		( "fititer", po::value<int>()->default_value(1000), "Maximum number of iterations" )
+		( "threads", po::value<unsigned int>()->default_value(0), "Number of threads, 0 means number of CPU cores. Results don't depend on this option" )
+	;
+	desc.add(fit);
+	desc.add(FreddiArguments::description());
+
+	po::variables_map vm;
+	try {
+		po::store( po::parse_command_line(ac, av, desc), vm );
+		if ( vm.count("help") ){
+			cout << desc << endl;
+			return 0;
+		}
+		po::notify(vm);
+		if ( vm["fitstep"].as<double>() <= 0. ){
+			throw po::error("--fitstep should be positive");
+		}
+	} catch (exception &e){
+		cerr << "Error: " << e.what() << endl;
+		return 1;
+	}
+
+	vector<string> names;
+	istringstream list(vm["fitparams"].as<string>());
+	for ( string name; getline(list, name, ','); ){
+		names.push_back(name);
+	}
+
+	try {
+		const LightCurve observed = read_light_curve(vm["lightcurve"].as<string>());
+		LightCurveFit fitter(vm, names, vm["fitcolumn"].as<string>(), observed, vm["threads"].as<unsigned int>());
+		const auto result = fitter.fit(log1p(vm["fitstep"].as<double>()), vm["fittol"].as<double>(), vm["fititer"].as<int>());
+
+		const int dof = static_cast<int>(observed.t.size()) - static_cast<int>(names.size());
+		cout << "# chi2 = " << result.chi2 << ", degrees of freedom = " << dof << ", iterations = " << result.iterations << ", models = " << result.evaluations << "\n";
+		if ( not result.converged ){
+			cout << "# Fit doesn't converge in " << result.iterations << " iterations" << "\n";
+		}
+		cout << "# parameter value error" << "\n";
+		for ( size_t j = 0; j < names.size(); ++j ){
+			cout << names[j] << "\t" << result.parameters[j] << "\t";
+			if ( result.covariance.empty() ){
+				cout << "nan";
+			} else{
+				cout << sqrt(result.covariance[j][j]);
+			}
+			cout << "\n";
+		}
+		if ( result.covariance.empty() ){
+			cout << "# Hessian of chi2 isn't positive definite, covariance is unknown" << endl;
+			return 0;
+		}
+		cout << "# covariance" << "\n";
+		for ( size_t j = 0; j < names.size(); ++j ){
+			cout << names[j];
+			for ( size_t k = 0; k < names.size(); ++k ){
+				cout << "\t" << result.covariance[j][k];
+			}
+			cout << "\n";
+		}
+		cout << flush;
+	} catch (exception &e){
+		cerr << "Error: " << e.what() << endl;
+		return 1;
+	}
+
+	return 0;
+}
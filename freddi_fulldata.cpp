@@ -0,0 +1,63 @@
+#include <boost/program_options.hpp>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "fulldata.hpp"
+
+
+namespace po = boost::program_options;
+using namespace std;
+
+
+
+int main(int ac, char *av[]){
+	po::options_description desc("Freddi fulldata - convert PREFIX_fulldata.bin written by freddi --fulldata --fulldataformat=binary into text files PREFIX_%d.dat");
+	desc.add_options()
+		( "help,h", "Produce help message" )
+		( "input", po::value<string>()->required(), "Binary fulldata file" )
+		( "prefix", po::value<string>()->default_value("freddi"), "Prefix for output filenames" )
+		( "dir,d", po::value<string>()->default_value("."), "Directory to write output files. It should exist" )
+	;
+	po::positional_options_description positional;
+	positional.add("input", 1);
+	po::variables_map vm;
+
+	try {
+		po::store( po::command_line_parser(ac, av).options(desc).positional(positional).run(), vm );
+		if ( vm.count("help") ){
+			cout << desc << endl;
+			return 0;
+		}
+		po::notify(vm);
+	} catch (exception &e){
+		cerr << "Error: " << e.what() << endl;
+		return 1;
+	}
+
+	try {
+		const FulldataBinaryReader reader(vm["input"].as<string>());
+		for ( uint64_t k = 0; k < reader.snapshots(); ++k ){
+			vector<vector<double>> columns;
+			vector<const double *> pointers;
+			for ( int c = 0; c < fulldata_columns; ++c ){
+				columns.push_back(reader.column(k, c));
+			}
+			for ( const auto &column : columns ){
+				pointers.push_back(column.data());
+			}
+			ostringstream filename;
+			filename << vm["dir"].as<string>() << "/" << vm["prefix"].as<string>() << "_" << reader.step(k) << ".dat";
+			ofstream output(filename.str());
+			write_fulldata_text(output, reader.t(k), reader.Mdot_in(k), reader.rows(k), pointers.data());
+		}
+	} catch (exception &e){
+		cerr << "Error: " << e.what() << endl;
+		return 1;
+	}
+
+	return 0;
+}
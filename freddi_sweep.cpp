@@ -0,0 +1,226 @@
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "arguments.hpp"
+#include "freddi_batch.hpp"
+#include "freddi_evolution.hpp"
+#include "output.hpp"
+#include "thread_pool.hpp"
+
+
+namespace po = boost::program_options;
+using namespace std;
+
+
+struct SweepModel{
+	string id;
+	vector<string> options;
+	vector<FreddiSummary> summaries;
+	string error;
+	bool finished = false;
+};
+
+
+vector<SweepModel> read_manifest(const string &filename){
+	ifstream input(filename);
+	if ( not input ){
+		throw runtime_error("Cannot open manifest file " + filename);
+	}
+	vector<SweepModel> models;
+	set<string> ids;
+	string line;
+	while ( getline(input, line) ){
+		const auto tokens = po::split_unix(line);
+		if ( tokens.empty() or tokens.front().front() == '#' ){
+			continue;
+		}
+		SweepModel model;
+		model.id = tokens.front();
+		model.options.assign(tokens.begin() + 1, tokens.end());
+		if ( not ids.insert(model.id).second ){
+			throw runtime_error("Model id " + model.id + " is not unique in manifest file");
+		}
+		models.push_back(model);
+	}
+	return models;
+}
+
+
+int main(int ac, char *av[]){
+	po::options_description desc("Freddi sweep - compute many models in parallel, all models are written to PREFIX.dat with their id in the first column.\n\nManifest file consists of lines 'ID [OPTIONS]', where OPTIONS are the same as for freddi executable. Options from the manifest have priority over the command line ones. Lines started with # are ignored");
+	po::options_description sweep("Sweep options");
+	sweep.add_options()
+		( "manifest", po::value<string>()->required(), "Manifest file with model ids and options" )
+		( "threads", po::value<unsigned int>()->default_value(0), "Number of threads, 0 means number of CPU cores" )
+		( "batch", po::value<unsigned int>()->default_value(0), "Number of consecutive models of the manifest computed by one thread together. Models with constant time step, implicit Euler scheme, simple iterations and the same Kramers or OPAL opacity are advanced in lockstep, so the solver processes them by SIMD instructions. 0 means up to 8 models, but not more than number of models per thread. Results don't depend on this option" )
+	;
+	desc.add(sweep);
+	const auto freddi_desc = FreddiArguments::description();
+	desc.add(freddi_desc);
+
+	po::variables_map vm;
+	po::parsed_options parsed(&desc);
+	vector<SweepModel> models;
+	// All models should have the same bands to be written to one file
+	vector<string> bands;
+	try {
+		parsed = po::parse_command_line(ac, av, desc);
+		po::store( parsed, vm );
+		if ( vm.count("help") ){
+			cout << desc << endl;
+			return 0;
+		}
+		po::notify(vm);
+		if ( vm.count("fulldata") ){
+			throw po::error("--fulldata is not supported by freddi-sweep");
+		}
+		models = read_manifest(vm["manifest"].as<string>());
+		bands = ( vm.count("filters") ? Photometry(vm["filters"].as<string>()) : Photometry() ).names();
+	} catch (exception &e){
+		cerr << "Error: " << e.what() << endl;
+		return 1;
+	}
+
+	ofstream output_sum( vm["dir"].as<string>() + "/" + vm["prefix"].as<string>() + ".dat" );
+	write_summary_header(output_sum, bands, "id ", "-  ");
+	output_sum << "#";
+	for ( int i = 0; i < ac; ++i ){
+		output_sum << " " << av[i];
+	}
+	output_sum << endl;
+
+	// Models are written in manifest order as soon as all previous models are finished
+	mutex output_mutex;
+	size_t next_to_write = 0;
+	auto write_finished = [&](){
+		for ( ; next_to_write < models.size() and models[next_to_write].finished; ++next_to_write ){
+			auto &model = models[next_to_write];
+			if ( not model.error.empty() ){
+				cerr << model.id << ": " << model.error << endl;
+			}
+			for ( const auto &s : model.summaries ){
+				output_sum << model.id << "\t";
+				write_summary_row(output_sum, s);
+				output_sum << "\n";
+			}
+			output_sum.flush();
+			vector<FreddiSummary>().swap(model.summaries);
+		}
+	};
+
+	// Every task computes a group of consecutive models, models of the group
+	// supported by FreddiBatch are computed together
+	ThreadPool pool(vm["threads"].as<unsigned int>());
+	size_t batch = vm["batch"].as<unsigned int>();
+	if ( batch == 0 ){
+		batch = min<size_t>( 8, max<size_t>( 1, models.size() / pool.size() ) );
+	}
+	for ( size_t first = 0; first < models.size(); first += batch ){
+		const size_t last = min(models.size(), first + batch);
+		pool.submit([first, last, &models, &parsed, &freddi_desc, &bands, &output_mutex, &write_finished](){
+			vector<unique_ptr<FreddiEvolution>> evolutions(last - first);
+			vector<unique_ptr<OutputSchedule>> schedules(last - first);
+			// Numbers of models in the group for every opacity law
+			map<string, vector<size_t>> batches;
+			for ( size_t k = 0; k < last - first; ++k ){
+				auto &model = models[first + k];
+				try{
+					po::variables_map model_vm;
+					po::store( po::command_line_parser(model.options).options(freddi_desc).run(), model_vm );
+					po::store( parsed, model_vm );
+					FreddiArguments::store_restart_options(model_vm);
+					po::notify(model_vm);
+					FreddiArguments args(model_vm);
+					// Models are computed in parallel already
+					args.solver_threads = 1;
+					evolutions[k].reset(new FreddiEvolution(args));
+					schedules[k].reset(new OutputSchedule(*evolutions[k]));
+					if ( evolutions[k]->photometry.names() != bands ){
+						throw invalid_argument("--filters in manifest should have the same bands as in command line");
+					}
+				} catch (exception &e){
+					model.error = string("Error: ") + e.what();
+					evolutions[k].reset();
+					continue;
+				}
+				if ( FreddiBatch::supports(evolutions[k]->args) ){
+					batches[evolutions[k]->oprel.type].push_back(k);
+				} else{
+					batches[""].push_back(k);
+				}
+			}
+
+			auto collect = [&](const size_t k){
+				auto &model = models[first + k];
+				FreddiEvolution &freddi = *evolutions[k];
+				model.summaries.insert(model.summaries.end(), freddi.observations.begin(), freddi.observations.end());
+				if ( schedules[k]->due(freddi) ){
+					freddi.calculate_observables();
+					model.summaries.push_back(freddi.summary());
+				}
+			};
+			for ( const auto &item : batches ){
+				const auto &ks = item.second;
+				if ( item.first.empty() or ks.size() == 1 ){
+					for ( size_t k : ks ){
+						try{
+							FreddiEvolution &freddi = *evolutions[k];
+							while ( freddi.can_step(freddi.args.Time) ){
+								try{
+									freddi.step(freddi.args.Time);
+								} catch (runtime_error &er){
+									models[first + k].error = er.what();
+									break;
+								}
+								collect(k);
+							}
+						} catch (exception &e){
+							models[first + k].error = string("Error: ") + e.what();
+						}
+					}
+					continue;
+				}
+				try{
+					vector<FreddiEvolution *> pointers;
+					for ( size_t k : ks ){
+						pointers.push_back(evolutions[k].get());
+					}
+					FreddiBatch freddi_batch(pointers);
+					for ( auto stepped = freddi_batch.step(); not stepped.empty(); stepped = freddi_batch.step() ){
+						for ( size_t j : stepped ){
+							collect(ks[j]);
+						}
+					}
+					for ( size_t j = 0; j < ks.size(); ++j ){
+						if ( not freddi_batch.error(j).empty() ){
+							models[first + ks[j]].error = freddi_batch.error(j);
+						}
+					}
+				} catch (exception &e){
+					for ( size_t k : ks ){
+						models[first + k].error = string("Error: ") + e.what();
+					}
+				}
+			}
+
+			lock_guard<mutex> lock(output_mutex);
+			for ( size_t i = first; i < last; ++i ){
+				models[i].finished = true;
+			}
+			write_finished();
+		});
+	}
+	pool.wait();
+
+	return 0;
+}
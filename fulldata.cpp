@@ -0,0 +1,178 @@
+#include "fulldata.hpp"
+
+#include <cstring>	// std::memcpy, std::strncmp
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "arguments.hpp"
+#include "binary_io.hpp"
+
+
+using namespace std;
+
+
+const char * const fulldata_column_names[fulldata_columns] = { "h", "R", "F", "Sigma", "Tph", "Tph_vis", "Height" };
+
+const char fulldata_magic[] = "FREDDIFD";
+const uint64_t fulldata_version = 1;
+const uint64_t header_size = 64;
+const uint64_t column_name_size = 16;
+const uint64_t index_record_size = 24;
+
+
+void write_fulldata_text(ostream &output, const double t, const double Mdot_in, const uint64_t N, const double * const *columns){
+	output << "#h      R  F      Sigma  Tph_vis Tph Height" << "\n";
+	output << "#cm^2/s cm dyn*cm g/cm^2 K       K   cm" << "\n";
+	output << "# Time = " << t / DAY << " Mdot_in = " << Mdot_in << "\n";
+	for ( uint64_t i = 0; i < N; ++i ){
+		output << columns[0][i];
+		for ( int c = 1; c < fulldata_columns; ++c ){
+			output << "\t" << columns[c][i];
+		}
+		output << "\n";
+	}
+}
+
+
+FulldataBinaryWriter::FulldataBinaryWriter(const string &filename):
+	output(filename, ios::binary)
+{
+	if ( not output ){
+		throw invalid_argument("Cannot open file " + filename);
+	}
+	buffer.insert(buffer.end(), fulldata_magic, fulldata_magic + 8);
+	put(buffer, fulldata_version);
+	put(buffer, static_cast<uint64_t>(fulldata_columns));
+	for ( int i = 0; i < 5; ++i ){
+		put(buffer, static_cast<uint64_t>(0));
+	}
+	for ( int c = 0; c < fulldata_columns; ++c ){
+		vector<char> name(column_name_size, '\0');
+		strncpy(name.data(), fulldata_column_names[c], column_name_size);
+		buffer.insert(buffer.end(), name.begin(), name.end());
+	}
+	output.write(buffer.data(), buffer.size());
+	position = buffer.size();
+}
+
+
+FulldataBinaryWriter::~FulldataBinaryWriter(){
+	close();
+}
+
+
+void FulldataBinaryWriter::write(const uint64_t i_t, const double t, const double Mdot_in, const uint64_t N, const double * const *columns){
+	index.push_back(position);
+	index.push_back(N);
+	uint64_t t_bits;
+	memcpy(&t_bits, &t, sizeof(t_bits));
+	index.push_back(t_bits);
+
+	buffer.clear();
+	put(buffer, i_t);
+	put(buffer, t);
+	put(buffer, Mdot_in);
+	put(buffer, N);
+	for ( int c = 0; c < fulldata_columns; ++c ){
+		for ( uint64_t i = 0; i < N; ++i ){
+			put(buffer, columns[c][i]);
+		}
+	}
+	output.write(buffer.data(), buffer.size());
+	position += buffer.size();
+}
+
+
+void FulldataBinaryWriter::close(){
+	if ( not output.is_open() ){
+		return;
+	}
+	buffer.clear();
+	for ( const uint64_t x : index ){
+		put(buffer, x);
+	}
+	output.write(buffer.data(), buffer.size());
+
+	buffer.clear();
+	put(buffer, static_cast<uint64_t>(index.size() / 3));
+	put(buffer, position);
+	output.seekp(24);
+	output.write(buffer.data(), buffer.size());
+	output.close();
+}
+
+
+FulldataBinaryReader::FulldataBinaryReader(const string &filename){
+	const int fd = open(filename.c_str(), O_RDONLY);
+	if ( fd < 0 ){
+		throw invalid_argument("Cannot open file " + filename);
+	}
+	struct stat st;
+	fstat(fd, &st);
+	size = st.st_size;
+	void *p = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+	::close(fd);
+	if ( p == MAP_FAILED ){
+		throw invalid_argument("Cannot map file " + filename);
+	}
+	data = static_cast<const char *>(p);
+
+	if ( size < header_size or strncmp(data, fulldata_magic, 8) != 0 or get_uint64(data + 8) != fulldata_version or get_uint64(data + 16) != fulldata_columns ){
+		munmap(const_cast<char *>(data), size);
+		throw invalid_argument(filename + " is not a binary fulldata file");
+	}
+	S = get_uint64(data + 24);
+	index_offset = get_uint64(data + 32);
+	if ( index_offset + S * index_record_size > size ){
+		munmap(const_cast<char *>(data), size);
+		throw invalid_argument(filename + " is truncated");
+	}
+}
+
+
+FulldataBinaryReader::~FulldataBinaryReader(){
+	munmap(const_cast<char *>(data), size);
+}
+
+
+uint64_t FulldataBinaryReader::snapshot_offset(const uint64_t k) const{
+	if ( k >= S ){
+		throw out_of_range("Snapshot number is out of range");
+	}
+	return get_uint64(data + index_offset + k * index_record_size);
+}
+
+
+uint64_t FulldataBinaryReader::step(const uint64_t k) const{
+	return get_uint64(data + snapshot_offset(k));
+}
+
+
+double FulldataBinaryReader::t(const uint64_t k) const{
+	return get_double(data + snapshot_offset(k) + 8);
+}
+
+
+double FulldataBinaryReader::Mdot_in(const uint64_t k) const{
+	return get_double(data + snapshot_offset(k) + 16);
+}
+
+
+uint64_t FulldataBinaryReader::rows(const uint64_t k) const{
+	return get_uint64(data + snapshot_offset(k) + 24);
+}
+
+
+vector<double> FulldataBinaryReader::column(const uint64_t k, const int c) const{
+	const uint64_t N = rows(k);
+	const char *p = data + snapshot_offset(k) + 32 + c * N * 8;
+	vector<double> v(N);
+	for ( uint64_t i = 0; i < N; ++i ){
+		v[i] = get_double(p + 8*i);
+	}
+	return v;
+}
@@ -0,0 +1,76 @@
+#ifndef _FULLDATA_HPP
+#define _FULLDATA_HPP
+
+
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+// Radial structure of the disk for one time step has columns h, R, F, Sigma,
+// Tph, Tph_vis and Height. It is written as text file PREFIX_%d.dat or as a
+// snapshot of binary file PREFIX_fulldata.bin with the following format. All
+// integers are uint64, all reals are float64, both are little-endian.
+//
+// Header, 64 bytes: magic "FREDDIFD", format version (1), number of columns
+// (7), number of snapshots S, offset of the index, three reserved zeros.
+// Then names of columns, 16 bytes each, padded by zeros.
+// Snapshot: step number, time (s), Mdot_in (g/s), number of rows N, then
+// every column as N reals.
+// Index: S records of three values: snapshot offset, N and time, so snapshot
+// k is found in O(1) from the record at index offset + 24 k.
+//
+// Number of snapshots and index offset are written when the file is closed,
+// they are zero for unfinished files.
+
+const int fulldata_columns = 7;
+extern const char * const fulldata_column_names[fulldata_columns];
+
+
+void write_fulldata_text(std::ostream &output, double t, double Mdot_in, uint64_t N, const double * const *columns);
+
+
+class FulldataBinaryWriter{
+private:
+	std::ofstream output;
+	uint64_t position;
+	std::vector<uint64_t> index;
+	std::vector<char> buffer;
+
+public:
+	explicit FulldataBinaryWriter(const std::string &filename);
+	~FulldataBinaryWriter();
+	void write(uint64_t i_t, double t, double Mdot_in, uint64_t N, const double * const *columns);
+	// Writes index and header, it is called by destructor
+	void close();
+};
+
+
+// Reader of PREFIX_fulldata.bin, the file is mapped into memory
+class FulldataBinaryReader{
+private:
+	const char *data;
+	uint64_t size;
+	uint64_t S, index_offset;
+
+	uint64_t snapshot_offset(uint64_t k) const;
+
+public:
+	explicit FulldataBinaryReader(const std::string &filename);
+	~FulldataBinaryReader();
+	FulldataBinaryReader(const FulldataBinaryReader&) = delete;
+	FulldataBinaryReader& operator=(const FulldataBinaryReader&) = delete;
+
+	uint64_t snapshots() const { return S; }
+	uint64_t step(uint64_t k) const;
+	double t(uint64_t k) const;
+	double Mdot_in(uint64_t k) const;
+	uint64_t rows(uint64_t k) const;
+	// Column c of snapshot k
+	std::vector<double> column(uint64_t k, int c) const;
+};
+
+
+#endif // _FULLDATA_HPP
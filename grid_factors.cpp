@@ -0,0 +1,27 @@
+#include "grid_factors.hpp"
+
+#include <cmath>
+
+#include "gsl_const_cgsm.h"
+
+
+void GridFactors::set(const std::vector<double> &h, const std::vector<double> &R, const double GM, const OpacityRelated &oprel){
+	const size_t N = h.size();
+	for ( auto v : {&W, &Sigma, &Tph_vis, &Qx, &Height} ){
+		v->resize(N);
+	}
+	const double Tph_vis_coef = pow( 3. / (8.*M_PI) / GSL_CONST_CGSM_STEFAN_BOLTZMANN_CONSTANT, 0.25 );
+	for ( size_t i = 0; i < N; ++i ){
+		W[i] = pow(h[i], oprel.n) / (1. - oprel.m) / oprel.D;
+		Sigma[i] = GM*GM / ( 4.*M_PI * pow(h[i], 3.) );
+		Tph_vis[i] = GM * pow(h[i], -1.75) * Tph_vis_coef;
+		Qx[i] = GSL_CONST_CGSM_SPEED_OF_LIGHT * GSL_CONST_CGSM_SPEED_OF_LIGHT / (4.*M_PI * R[i]*R[i]);
+		Height[i] = oprel.Height(R[i], 1.);
+	}
+	structure_row.clear();
+	if ( oprel.structure ){
+		for ( size_t i = 0; i < N; ++i ){
+			structure_row.push_back(oprel.structure->row(h[i]));
+		}
+	}
+}
@@ -0,0 +1,34 @@
+#ifndef _GRID_FACTORS_HPP
+#define _GRID_FACTORS_HPP
+
+
+#include <vector>
+
+#include "opacity_related.hpp"
+
+
+// Factors of per-radius quantities which depend on the grid only, so the
+// time step calculates one power of F per point for every quantity. They
+// don't change when the outer boundary moves inside, because it only drops
+// the last points of the grid, set() should be called if h is changed
+class GridFactors{
+public:
+	// W = F^(1-m) W_factor, W_factor = h^n / (1-m) / D
+	std::vector<double> W;
+	// Sigma = W Sigma_factor, Sigma_factor = GM^2 / (4 pi h^3)
+	std::vector<double> Sigma;
+	// Tph_vis = F^(1/4) Tph_vis_factor, Tph_vis_factor = GM h^-1.75 (3 / (8 pi sigma_SB))^(1/4)
+	std::vector<double> Tph_vis;
+	// Qx = C_irr eta Mdot_in Qx_factor, Qx_factor = c^2 / (4 pi R^2)
+	std::vector<double> Qx;
+	// Height = F^Height_exp_F Height_factor
+	std::vector<double> Height;
+	// Row of OpacityRelated::structure table for tabulated opacity, it is
+	// empty for power laws
+	std::vector<double> structure_row;
+
+	void set(const std::vector<double> &h, const std::vector<double> &R, double GM, const OpacityRelated &oprel);
+};
+
+
+#endif // _GRID_FACTORS_HPP
@@ -0,0 +1,320 @@
+#include "light_curve_fit.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+#include "output.hpp"
+
+
+namespace po = boost::program_options;
+using namespace std;
+
+
+LightCurve read_light_curve(const string &filename){
+	ifstream input(filename);
+	if ( not input ){
+		throw runtime_error("Cannot open light curve file " + filename);
+	}
+	vector<array<double, 3>> points;
+	string line;
+	while ( getline(input, line) ){
+		if ( line.empty() or line.front() == '#' ){
+			continue;
+		}
+		istringstream columns(line);
+		array<double, 3> point;
+		if ( not (columns >> point[0] >> point[1] >> point[2]) ){
+			throw runtime_error("Wrong line in " + filename + ": " + line);
+		}
+		if ( point[0] < 0. or not ( point[2] > 0. ) ){
+			throw runtime_error("Time should be non-negative and error should be positive in " + filename + ": " + line);
+		}
+		points.push_back(point);
+	}
+	if ( points.empty() ){
+		throw runtime_error("Light curve file " + filename + " is empty");
+	}
+	sort(points.begin(), points.end());
+
+	LightCurve light_curve;
+	for ( const auto &point : points ){
+		light_curve.t.push_back(point[0] * DAY);
+		light_curve.value.push_back(point[1]);
+		light_curve.error.push_back(point[2]);
+	}
+	return light_curve;
+}
+
+
+LightCurveFit::LightCurveFit(const po::variables_map &vm, const vector<string> &names, const string &column, const LightCurve &observed, const unsigned int n_threads):
+	vm(vm),
+	names(names),
+	column(column),
+	observed(observed),
+	pool(n_threads),
+	evaluations(0)
+{
+	if ( names.empty() ){
+		throw invalid_argument("No parameters to fit");
+	}
+	for ( const auto &name : names ){
+		if ( not vm.count(name) or vm[name].value().type() != typeid(double) ){
+			throw invalid_argument("Fitted parameter " + name + " should be a double option of freddi with a value");
+		}
+		if ( count(names.begin(), names.end(), name) > 1 ){
+			throw invalid_argument("Fitted parameter " + name + " is repeated");
+		}
+		p_0.push_back(vm[name].as<double>());
+		if ( p_0.back() == 0. ){
+			throw invalid_argument("Initial value of fitted parameter " + name + " should be non-zero");
+		}
+	}
+
+	// Options and the column are checked by the first model
+	const FreddiEvolution freddi(arguments(vecd(names.size(), 0.)));
+	FreddiSummary summary;
+	summary.m.resize(freddi.photometry.bands.size());
+	summary_column(summary, freddi.photometry.names(), column);
+	if ( find(names.begin(), names.end(), "numin") == names.end() and find(names.begin(), names.end(), "numax") == names.end() ){
+		band_X = freddi.band_table();
+	}
+}
+
+
+FreddiArguments LightCurveFit::arguments(const vecd &x) const{
+	po::variables_map model_vm(vm);
+	for ( size_t j = 0; j < names.size(); ++j ){
+		model_vm.at(names[j]).value() = p_0[j] * exp(x[j]);
+	}
+	FreddiArguments args(model_vm);
+	// The last step finishes after the last observation
+	args.Time = observed.t.back() + args.tau;
+	args.observation_times = observed.t;
+	// Models are computed in parallel already
+	args.solver_threads = 1;
+	return args;
+}
+
+
+double LightCurveFit::model_chi2(const vecd &x) const{
+	FreddiEvolution freddi(arguments(x), band_X);
+	const auto bands = freddi.photometry.names();
+	double chi2 = 0.;
+	size_t i = 0;
+	while ( i < observed.t.size() and freddi.can_step(freddi.args.Time) ){
+		freddi.step(freddi.args.Time);
+		for ( const auto &s : freddi.observations ){
+			const double dif = ( summary_column(s, bands, column) - observed.value[i] ) / observed.error[i];
+			chi2 += dif * dif;
+			++i;
+		}
+	}
+	if ( i < observed.t.size() ){
+		throw runtime_error("Model doesn't reach the last observation");
+	}
+	return std::isnan(chi2) ? INFINITY : chi2;
+}
+
+
+vecd LightCurveFit::chi2(const vector<vecd> &xs){
+	vecd values(xs.size());
+	for ( size_t k = 0; k < xs.size(); ++k ){
+		pool.submit([this, &xs, &values, k](){
+			try{
+				values[k] = model_chi2(xs[k]);
+			} catch (exception &){
+				values[k] = INFINITY;
+			}
+		});
+	}
+	pool.wait();
+	evaluations += xs.size();
+	return values;
+}
+
+
+LightCurveFitResult LightCurveFit::fit(const double step, const double tolerance, const int max_iterations){
+	const size_t n = names.size();
+	evaluations = 1;
+	LightCurveFitResult result;
+
+	// Vertices of the simplex and their chi^2
+	vector<vecd> x(n+1, vecd(n, 0.));
+	vecd f(n+1);
+	f[0] = model_chi2(x[0]);
+	if ( std::isinf(f[0]) ){
+		throw runtime_error("Model with initial parameters has infinite chi^2");
+	}
+	for ( size_t j = 0; j < n; ++j ){
+		x[j+1][j] = step;
+	}
+	const vecd f_edges = chi2(vector<vecd>(x.begin() + 1, x.end()));
+	copy(f_edges.begin(), f_edges.end(), f.begin() + 1);
+
+	// Points are computed speculatively only if there are spare threads
+	const bool speculative = pool.size() > 1;
+	vector<size_t> order(n+1);
+	result.converged = false;
+	for ( result.iterations = 0; result.iterations < max_iterations; ++result.iterations ){
+		iota(order.begin(), order.end(), 0);
+		stable_sort(order.begin(), order.end(), [&f](const size_t i, const size_t j){ return f[i] < f[j]; });
+		vector<vecd> x_sorted(n+1);
+		vecd f_sorted(n+1);
+		for ( size_t i = 0; i <= n; ++i ){
+			x_sorted[i] = x[order[i]];
+			f_sorted[i] = f[order[i]];
+		}
+		x.swap(x_sorted);
+		f.swap(f_sorted);
+		if ( f[n] - f[0] <= tolerance ){
+			result.converged = true;
+			break;
+		}
+
+		vecd centroid(n, 0.);
+		for ( size_t i = 0; i < n; ++i ){
+			for ( size_t j = 0; j < n; ++j ){
+				centroid[j] += x[i][j] / n;
+			}
+		}
+		// Reflection, expansion, outside and inside contraction
+		const double coefficients[] = {1., 2., 0.5, -0.5};
+		vector<vecd> candidates(4, vecd(n));
+		for ( int k = 0; k < 4; ++k ){
+			for ( size_t j = 0; j < n; ++j ){
+				candidates[k][j] = centroid[j] + coefficients[k] * ( centroid[j] - x[n][j] );
+			}
+		}
+		vecd f_candidates(4, NAN);
+		if ( speculative ){
+			f_candidates = chi2(candidates);
+		}
+		auto value = [&](const int k) -> double{
+			if ( std::isnan(f_candidates[k]) ){
+				f_candidates[k] = chi2(vector<vecd>(1, candidates[k])).front();
+			}
+			return f_candidates[k];
+		};
+
+		int accepted;
+		if ( value(0) < f[0] ){
+			accepted = value(1) < value(0) ? 1 : 0;
+		} else if ( value(0) < f[n-1] ){
+			accepted = 0;
+		} else if ( value(0) < f[n] ){
+			accepted = value(2) <= value(0) ? 2 : -1;
+		} else{
+			accepted = value(3) < f[n] ? 3 : -1;
+		}
+		if ( accepted >= 0 ){
+			x[n] = candidates[accepted];
+			f[n] = f_candidates[accepted];
+			continue;
+		}
+
+		// Shrink towards the best vertex
+		for ( size_t i = 1; i <= n; ++i ){
+			for ( size_t j = 0; j < n; ++j ){
+				x[i][j] = x[0][j] + 0.5 * ( x[i][j] - x[0][j] );
+			}
+		}
+		const vecd f_shrunk = chi2(vector<vecd>(x.begin() + 1, x.end()));
+		copy(f_shrunk.begin(), f_shrunk.end(), f.begin() + 1);
+	}
+	const size_t best = min_element(f.begin(), f.end()) - f.begin();
+
+	for ( size_t j = 0; j < n; ++j ){
+		result.parameters.push_back(p_0[j] * exp(x[best][j]));
+	}
+	result.chi2 = f[best];
+	result.covariance = covariance(x[best], f[best]);
+	result.evaluations = evaluations;
+	return result;
+}
+
+
+vector<vecd> LightCurveFit::covariance(const vecd &x, const double chi2_x){
+	const size_t n = x.size();
+	const double h = hessian_step;
+
+	// Points x + h (s_j e_j + s_k e_k) for all pairs j <= k and signs, for
+	// j == k only s_j = s_k are used
+	vector<vecd> points;
+	auto shifted = [&x, h](const size_t j, const double s_j, const size_t k, const double s_k){
+		vecd y(x);
+		y[j] += s_j * h;
+		y[k] += s_k * h;
+		return y;
+	};
+	for ( size_t j = 0; j < n; ++j ){
+		points.push_back(shifted(j, 0.5, j, 0.5));
+		points.push_back(shifted(j, -0.5, j, -0.5));
+		for ( size_t k = j+1; k < n; ++k ){
+			for ( const double s_j : {1., -1.} ){
+				for ( const double s_k : {1., -1.} ){
+					points.push_back(shifted(j, s_j, k, s_k));
+				}
+			}
+		}
+	}
+	const vecd f = chi2(points);
+
+	vector<vecd> H(n, vecd(n));
+	size_t i = 0;
+	for ( size_t j = 0; j < n; ++j ){
+		H[j][j] = ( f[i] - 2. * chi2_x + f[i+1] ) / ( h * h );
+		i += 2;
+		for ( size_t k = j+1; k < n; ++k ){
+			H[j][k] = H[k][j] = ( f[i] - f[i+1] - f[i+2] + f[i+3] ) / ( 4. * h * h );
+			i += 4;
+		}
+	}
+
+	// Cholesky decomposition H = L L^T
+	vector<vecd> L(n, vecd(n, 0.));
+	for ( size_t j = 0; j < n; ++j ){
+		for ( size_t k = 0; k <= j; ++k ){
+			double sum = H[j][k];
+			for ( size_t m = 0; m < k; ++m ){
+				sum -= L[j][m] * L[k][m];
+			}
+			if ( j == k ){
+				if ( not ( sum > 0. ) or std::isinf(sum) ){
+					return vector<vecd>();
+				}
+				L[j][j] = sqrt(sum);
+			} else{
+				L[j][k] = sum / L[k][k];
+			}
+		}
+	}
+	// Columns of H^{-1} from L L^T c = e_k
+	vector<vecd> cov(n, vecd(n));
+	for ( size_t k = 0; k < n; ++k ){
+		vecd c(n);
+		for ( size_t j = 0; j < n; ++j ){
+			double sum = j == k ? 1. : 0.;
+			for ( size_t m = 0; m < j; ++m ){
+				sum -= L[j][m] * c[m];
+			}
+			c[j] = sum / L[j][j];
+		}
+		for ( size_t j = n; j-- > 0; ){
+			double sum = c[j];
+			for ( size_t m = j+1; m < n; ++m ){
+				sum -= L[m][j] * c[m];
+			}
+			c[j] = sum / L[j][j];
+		}
+		// Covariance of p = p_0 exp(x) is p_j p_k cov(x_j, x_k)
+		for ( size_t j = 0; j < n; ++j ){
+			cov[j][k] = 2. * c[j] * p_0[j] * exp(x[j]) * p_0[k] * exp(x[k]);
+		}
+	}
+	return cov;
+}
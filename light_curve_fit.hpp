@@ -0,0 +1,84 @@
+#ifndef _LIGHT_CURVE_FIT_HPP
+#define _LIGHT_CURVE_FIT_HPP
+
+
+#include <boost/program_options.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "arguments.hpp"
+#include "freddi_evolution.hpp"
+#include "thread_pool.hpp"
+
+
+// Observed light curve sorted by time, times are in seconds, values and
+// errors are in units of the fitted column of PREFIX.dat
+struct LightCurve{
+	vecd t, value, error;
+};
+
+// Reads file with columns time (days), value and error, lines started with #
+// are ignored
+LightCurve read_light_curve(const std::string &filename);
+
+
+struct LightCurveFitResult{
+	// Best-fit values of parameters in units of their options
+	vecd parameters;
+	double chi2;
+	int iterations, evaluations;
+	// Whether the simplex converged in less than the maximum number of iterations
+	bool converged;
+	// Covariance of parameters, it is empty if Hessian of chi^2 isn't
+	// positive definite
+	std::vector<vecd> covariance;
+};
+
+
+// Least squares fit of the light curve by freddi models. Fitted parameters
+// are double options of freddi, the other options are the same for all
+// models. Parameters are varied as p = p_0 exp(x), where p_0 are values of
+// the options, so they keep their signs. Minimum of chi^2 is found by
+// Nelder-Mead method over x. Candidate points of every iteration (reflection,
+// expansion and both contractions) are computed in parallel, only the
+// needed ones are computed by one thread, so results don't depend on the
+// number of threads. Models which fail or don't reach the last observation
+// have infinite chi^2. Covariance is 2 H^{-1}, where H is Hessian of chi^2
+// found by finite differences
+class LightCurveFit{
+private:
+	const boost::program_options::variables_map vm;
+	const std::vector<std::string> names;
+	const std::string column;
+	const LightCurve observed;
+	vecd p_0;
+	ThreadPool pool;
+	// X-ray band table of the first model, it is used by all models if the
+	// band isn't fitted
+	std::shared_ptr<const BandEmissivity> band_X;
+	int evaluations;
+
+	FreddiArguments arguments(const vecd &x) const;
+	double model_chi2(const vecd &x) const;
+	// Chi^2 of the points computed in parallel
+	vecd chi2(const std::vector<vecd> &xs);
+	std::vector<vecd> covariance(const vecd &x, double chi2_x);
+
+public:
+	// Step of x for Hessian
+	static constexpr double hessian_step = 1e-2;
+
+	// names are options of vm to fit, column is name of PREFIX.dat column,
+	// n_threads is number of threads, 0 means number of CPU cores
+	LightCurveFit(const boost::program_options::variables_map &vm, const std::vector<std::string> &names, const std::string &column, const LightCurve &observed, unsigned int n_threads = 0);
+
+	// Minimises chi^2 starting from the simplex with edges step along every x.
+	// It converges when chi^2 of the vertices of the simplex differ by less
+	// than tolerance. Throws std::runtime_error if the model with initial
+	// parameters fails
+	LightCurveFitResult fit(double step, double tolerance, int max_iterations);
+};
+
+
+#endif // _LIGHT_CURVE_FIT_HPP
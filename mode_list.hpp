@@ -0,0 +1,29 @@
+#ifndef _MODE_LIST_HPP
+#define _MODE_LIST_HPP
+
+
+#include <stdexcept>
+#include <string>
+
+
+// Compile-time list of types implementing one kind of model mode selected by
+// an option, e.g. irradiation factor or outer boundary condition, see
+// disc_modes.hpp. Every type has static function has_name(name). Number of
+// the mode in the list is found once by mode_index(), then the code using the
+// mode is called through the table of its instantiations for every type of
+// the list, so hot loops have neither string comparisons nor mode branches
+template <typename... Modes>
+struct ModeList{};
+
+
+inline int mode_index(ModeList<>, const std::string &name, int index = 0){
+	throw std::invalid_argument(name);
+}
+
+template <typename Mode, typename... Modes>
+int mode_index(ModeList<Mode, Modes...>, const std::string &name, const int index = 0){
+	return Mode::has_name(name) ? index : mode_index(ModeList<Modes...>(), name, index + 1);
+}
+
+
+#endif // _MODE_LIST_HPP
@@ -3,26 +3,600 @@
 
 
 #include <cmath>		// fabs
-#include <csignal>		// sig_atomic_t
+#include <algorithm>	// std::equal, std::max, std::min
 #include <exception>	// std::exception
 #include <functional>	// std::function
-#include <iostream>		// Could be removed
+#include <memory>		// std::shared_ptr
+#include <stdexcept>	// std::runtime_error
 #include <vector>
 
+#include "thread_pool.hpp"
+
 
 typedef std::vector<double> vecd;
+// W functor interface: wunc(x, y, w, first, last), where x is array of x_i,
+// y — array of y(x_i,t), w is array to write w(x_i,y_i) for first <= i <= last.
+// Solvers are templates over functor type, so it could be inlined
+typedef std::function<void (const double *, const double *, double *, int, int)> wunc_t;
 
 
 double mean_square_rel(const vecd &A, const vecd &B, int first, int last);
 double max_dif_rel(const vecd &A, const vecd &B, int first, int last);
 
+// Variable step BDF2 method for the step of length tau after the step of
+// length tau_prev from w_prev to w is
+// (1+2r)/(1+r) w_new - (1+r) w + r^2/(1+r) w_prev = tau y''_new, r = tau/tau_prev,
+// i.e. it is implicit Euler step from w_start = ((1+r)^2 w - r^2 w_prev) / (1+2r).
+// Function writes w_start[i] for first <= i <= last, w_start can be the same
+// array as w_prev, and returns the length of implicit Euler step
+double bdf2_start(double tau, double tau_prev, const double *w, const double *w_prev, double *w_start, int first, int last);
+
+
+// Solver of \frac{dw}{dt}=\frac{d^2y}{dx^2}, y=y(x,t) — ?, w = w (x,y)
+// Object keeps its buffers between calls, they are reallocated only if size
+// of the grid is changed. Coefficients depending on grid and time step only
+// are recalculated only if x or tau is changed
+//
+// Grids of at least partition_N points are solved by nonuniform_1_2 and
+// nonuniform_1_2_newton in blocks of block_size points, see set_threads().
+// Tridiagonal systems are solved by partition method: every block is solved
+// independently with unknown values at its ends, then the values at the
+// ends are found from the small tridiagonal system connecting the blocks.
+// Blocks depend on the grid size only, so results don't depend on number of
+// threads. Other loops over the grid and max_dif_rel are split into the same
+// blocks, their results don't depend on the blocks at all
+class NonlinearDiffusion{
+public:
+	static const int block_size = 4096;
+
+private:
+	int N = 0; // N_x+1
+	vecd x_coef;
+	double tau_coef = 0.;
+	vecd a, b, frac;
+	vecd W, f, K_0, K_1, CC, alpha, beta;
+	vecd W_0, W_1, W_CC; // used by nonuniform_1_2_iterationW only
+	vecd dW, G; // used by nonuniform_1_2_newton only
+	int iterations = 0;
+	double residual = 0.;
+	bool divergence_heuristic = false;
+	// Threads are shared by copies of the object, it is null for one thread
+	std::shared_ptr<ThreadPool> pool;
+	int partition_N = 0;
+	// Used by partition method only: beta_left is the part of beta
+	// proportional to the value before the block, block_max is partial
+	// max_dif_rel, other arrays are for blocks and the system of their ends
+	vecd beta_left, block_max;
+	vecd v_first, v_last, left_first, left_last, right_first, right_last;
+	vecd ends_lower, ends_diag, ends_upper, ends_rhs;
+
+	void prepare(double tau, const vecd &x, int N);
+	// Calls task(k) for 0 <= k < n by threads of the pool
+	void run(int n, const std::function<void (int)> &task);
+	bool partitioned() const { return partition_N > 0 and N >= partition_N; }
+	// Maximum of f(first_k, last_k) over blocks of for_blocks, f should
+	// return non-negative value
+	template <typename Function>
+	double max_over_blocks(int first, int last, const Function &f);
+	// max_dif_rel(A, B, 1, N-2)
+	double dif_rel(const vecd &A, const vecd &B);
+	// Solves -a_i y_{i-1} + c(i) y_i - b_i y_{i+1} = rhs_i for 0 < i < N-1 and
+	// -y_{N-2} + c_last y_{N-1} = rhs_last by partition method, y_0 = left.
+	// rhs can be the same array as y
+	template <typename Diagonal>
+	void partitioned_tridiagonal(const Diagonal &c, double c_last, const double *rhs, double rhs_last, double left, double *y);
+
+public:
+	// Use n_threads threads (0 means number of CPU cores) and partition
+	// method for grids of at least min_N points, 0 means never. Partition
+	// method is used for large grids even with one thread, so results
+	// don't depend on the number of threads
+	void set_threads(unsigned int n_threads, int min_N);
+	// Whether solver has more than one thread
+	bool threaded() const { return pool != nullptr; }
+	// Calls f(first_k, last_k) for blocks of block_size points covering
+	// first <= i <= last, in parallel if the range has at least partition_N
+	// points, f should be safe to call concurrently for different blocks
+	template <typename Function>
+	void for_blocks(int first, int last, const Function &f);
+
+	// Number of iterations made by the last call of a solver
+	int last_iterations() const { return iterations; }
+	// Relative difference between the last two iterations of the last call
+	double last_residual() const { return residual; }
+	// Whether the last call detected divergence: for simple iterations the
+	// difference between iterations stopped decreasing, for Newton method
+	// the correction was damped
+	bool last_divergence_heuristic() const { return divergence_heuristic; }
+
+	template <typename Wunc>
+	void nonuniform_1_2 (const double tau,
+						 const double eps, // reletive error for w
+						 const double left_bounder_cond, // y(left_border,Time+tau) = left_bounder_cond
+						 const double right_bounder_cond, // \frac{y(right_border,Time+tau)}{dx} = right_bounder_cond
+						 const Wunc &wunc,
+						 const vecd &x, // array with (non)uniform grid
+						 vecd &y, // array with initial coundition and for results
+						 const double *w_start = nullptr // w at the start of the step, w(x, y) if it is null
+						);
+
+	// The same problem as nonuniform_1_2 solved by Newton-Raphson method.
+	// Wunc should also have method derivative(x, y, w, dw, first, last)
+	// writing dw/dy into dw[i] for given w[i] = w(x_i, y_i)
+	template <typename Wunc>
+	void nonuniform_1_2_newton (const double tau,
+								const double eps, // reletive error for y
+								const double left_bounder_cond, // y(left_border,Time+tau) = left_bounder_cond
+								const double right_bounder_cond, // \frac{y(right_border,Time+tau)}{dx} = right_bounder_cond
+								const Wunc &wunc,
+								const vecd &x, // array with (non)uniform grid
+								vecd &y, // array with initial coundition and for results
+								const double *w_start = nullptr // w at the start of the step, w(x, y) if it is null
+								);
+
+	template <typename Wunc>
+	void nonuniform_1_2_iterationW (const double tau,
+									const double eps, // reletive error for w
+									const double left_bounder_cond, // y(left_border,Time+tau) = left_bounder_cond
+									const double right_bounder_cond, // \frac{y(right_border,Time+tau)}{dx} = right_bounder_cond
+									const Wunc &wunc,
+									const vecd &x, // array with (non)uniform grid
+									vecd &y, // array with initial coundition and for results
+									const double *w_start = nullptr // w at the start of the step, w(x, y) if it is null
+									);
+
+	template <typename Wunc>
+	void nonuniform_2_2 (const double tau,
+						 const double eps, // reletive error for w
+						 const double left_bounder_cond, // \frac{y(left_border,Time+tau)}{dx} = left_bounder_cond
+						 const double right_bounder_cond, // \frac{y(right_border,Time+tau)}{dx} = right_bounder_cond
+						 const Wunc &wunc,
+						 const vecd &x, // array with (non)uniform grid
+						 vecd &y, // array with initial coundition and for results
+						 const double *w_start = nullptr // w at the start of the step, w(x, y) if it is null
+						);
+};
+
+
+// Wunc evaluated by NonlinearDiffusion::for_blocks, so W of large grids is
+// calculated in parallel
+template <typename Wunc>
+class ParallelWunc{
+private:
+	const Wunc &wunc;
+	NonlinearDiffusion &solver;
+
+public:
+	ParallelWunc(const Wunc &wunc, NonlinearDiffusion &solver):
+		wunc(wunc), solver(solver) {}
+
+	void operator()(const double *x, const double *y, double *w, const int first, const int last) const{
+		solver.for_blocks(first, last, [&](const int first_k, const int last_k){
+			wunc(x, y, w, first_k, last_k);
+		});
+	}
+
+	void derivative(const double *x, const double *y, const double *w, double *dw, const int first, const int last) const{
+		solver.for_blocks(first, last, [&](const int first_k, const int last_k){
+			wunc.derivative(x, y, w, dw, first_k, last_k);
+		});
+	}
+};
+
+
+template <typename Function>
+void NonlinearDiffusion::for_blocks(const int first, const int last, const Function &f){
+	const int n = last - first + 1;
+	if ( partition_N <= 0 or n < partition_N ){
+		f(first, last);
+		return;
+	}
+	run( (n + block_size - 1) / block_size, [&](const int k){
+		f( first + k * block_size, std::min(last, first + (k+1) * block_size - 1) );
+	});
+}
+
+
+template <typename Function>
+double NonlinearDiffusion::max_over_blocks(const int first, const int last, const Function &f){
+	const int n = last - first + 1;
+	if ( partition_N <= 0 or n < partition_N ){
+		return f(first, last);
+	}
+	const int blocks = (n + block_size - 1) / block_size;
+	block_max.resize(blocks);
+	run( blocks, [&](const int k){
+		block_max[k] = f( first + k * block_size, std::min(last, first + (k+1) * block_size - 1) );
+	});
+	double max = 0.;
+	for ( int k = 0; k < blocks; ++k ){
+		max = fmax( max, block_max[k] );
+	}
+	return max;
+}
+
+
+template <typename Diagonal>
+void NonlinearDiffusion::partitioned_tridiagonal(const Diagonal &c, const double c_last, const double *rhs, const double rhs_last, const double left, double *y){
+	// Ends of blocks are S_p = p block_size for p < P and S_P = N-1, block p
+	// consists of points S_p < i < S_{p+1}
+	const int P = std::max(1, (N-1) / block_size);
+	auto end = [P, this](const int p) -> int{ return p < P ? p * block_size : N-1; };
+	for ( auto v : {&v_first, &v_last, &left_first, &left_last, &right_first, &right_last, &ends_lower, &ends_diag, &ends_upper, &ends_rhs} ){
+		v->resize(P+1);
+	}
+	beta_left.resize(N);
+
+	// Solution in the block is y_i = v_i + y_{S_p} left_i + y_{S_{p+1}} right_i,
+	// sweep gives alpha and beta = v + y_{S_p} beta_left, values at the first
+	// and the last points are kept for the system of ends
+	run(P, [&](const int p){
+		const int first = end(p) + 1, last = end(p+1) - 1;
+		alpha[first] = 0.;
+		beta[first] = 0.;
+		beta_left[first] = 1.;
+		for ( int i = first; i <= last; ++i ){
+			const double denominator = c(i) - alpha[i] * a[i];
+			alpha[i+1] = b[i] / denominator;
+			beta[i+1] = ( beta[i] * a[i] + rhs[i] ) / denominator;
+			beta_left[i+1] = beta_left[i] * a[i] / denominator;
+		}
+		v_last[p] = beta[last+1];
+		left_last[p] = beta_left[last+1];
+		right_last[p] = alpha[last+1];
+		double v = 0., l = 0., r = 1.;
+		for ( int i = last; i >= first; --i ){
+			v = alpha[i+1] * v + beta[i+1];
+			l = alpha[i+1] * l + beta_left[i+1];
+			r = alpha[i+1] * r;
+		}
+		v_first[p] = v;
+		left_first[p] = l;
+		right_first[p] = r;
+	});
+
+	// Equations at the ends with y_{S_p-1} and y_{S_p+1} from the blocks
+	for ( int p = 1; p < P; ++p ){
+		const int i = end(p);
+		ends_lower[p] = - a[i] * left_last[p-1];
+		ends_diag[p] = c(i) - a[i] * right_last[p-1] - b[i] * left_first[p];
+		ends_upper[p] = - b[i] * right_first[p];
+		ends_rhs[p] = rhs[i] + a[i] * v_last[p-1] + b[i] * v_first[p];
+	}
+	ends_lower[P] = - left_last[P-1];
+	ends_diag[P] = c_last - right_last[P-1];
+	ends_upper[P] = 0.;
+	ends_rhs[P] = rhs_last + v_last[P-1];
+	ends_rhs[1] -= ends_lower[1] * left;
+	for ( int p = 2; p <= P; ++p ){
+		const double ratio = ends_lower[p] / ends_diag[p-1];
+		ends_diag[p] -= ratio * ends_upper[p-1];
+		ends_rhs[p] -= ratio * ends_rhs[p-1];
+	}
+	y[end(P)] = ends_rhs[P] / ends_diag[P];
+	for ( int p = P-1; p > 0; --p ){
+		y[end(p)] = ( ends_rhs[p] - ends_upper[p] * y[end(p+1)] ) / ends_diag[p];
+	}
+
+	run(P, [&](const int p){
+		const int first = end(p) + 1, last = end(p+1) - 1;
+		const double y_left = p > 0 ? y[end(p)] : left;
+		for ( int i = last; i >= first; --i ){
+			y[i] = alpha[i+1] * y[i+1] + beta[i+1] + y_left * beta_left[i+1];
+		}
+	});
+}
+
+
+template <typename Wunc>
+void NonlinearDiffusion::nonuniform_1_2 (const double tau,
+										 const double eps, // reletive error for w
+										 const double left_bounder_cond, // y(left_border,Time+tau) = left_bounder_cond
+										 const double right_bounder_cond, // \frac{y(right_border,Time+tau)}{dx} = right_bounder_cond
+										 const Wunc &wunc,
+										 const vecd &x, // array with (non)uniform grid
+										 vecd &y, // array with initial coundition and for results
+										 const double *w_start // w at the start of the step, w(x, y) if it is null
+									 	){
+	const int N = fmin(x.size(), y.size()); // N_x+1
+	prepare(tau, x, N);
+	wunc(x.data(), y.data(), W.data(), 1, N-1);
+	const double *w0 = w_start != nullptr ? w_start : W.data();
+	const double frac_last = ( x[N-1] - x[N-2] ) * ( x[N-1] - x[N-2] ) * 0.5 / tau;
+	for_blocks(1, N-2, [&](const int first, const int last){
+		for ( int i = first; i <= last; ++i ){
+			f[i] = frac[i] * w0[i];
+			K_1[i] = frac[i] * W[i] / y[i];
+			CC[i] = K_0[i] = K_1[i] * (1. + 2.*eps);
+		}
+	});
+	f[N-1] = frac_last * w0[N-1];
+	K_1[N-1] = frac_last * W[N-1] / y[N-1];
+	CC[N-1] = K_0[N-1] = K_1[N-1] * (1. + 2.*eps);
+
+	auto iteration = [&](vecd &K) -> void{ // [&] <-> [&wunc, &x, &y, &frac, &a, &b, &f, N, left_bounder_cond, right_bounder_cond]
+		if ( partitioned() ){
+			partitioned_tridiagonal([&K](const int i){ return 2. + K[i]; }, 1. + K[N-1], f.data(), (x[N-1] - x[N-2] ) * right_bounder_cond + f[N-1], left_bounder_cond, y.data());
+		} else{
+			alpha[1] = 0.;
+			beta[1] = left_bounder_cond;
+			for ( int i = 1; i < N-1; ++i ){
+				double c = 2. + K[i];
+				alpha[i+1] = b[i] / ( c - alpha[i] * a[i] );
+				beta[i+1] = ( beta[i] * a[i] + f[i] ) / ( c - alpha[i] * a[i] );
+			}
+			y[N-1] = ( (x[N-1] - x[N-2] ) * right_bounder_cond + f[N-1] + beta[N-1] ) / ( 1. + K[N-1] - alpha[N-1] );
+			for ( int i = N-2; i > 0; --i )
+				y[i] = alpha[i+1] * y[i+1] + beta[i+1];
+		}
+		y[0] = left_bounder_cond;
+		wunc(x.data(), y.data(), W.data(), 1, N-1);
+		for_blocks(1, N-2, [&](const int first, const int last){
+			for ( int i = first; i <= last; ++i )
+				K[i] = frac[i] * W[i] / y[i];
+		});
+	};
+
+	bool flag = false;	int j = 0;	double delta;
+	divergence_heuristic = false;
+	while( ( residual = dif_rel(K_1, K_0) ) > eps ){
+		if ( dif_rel(K_1, CC) > 0. and flag == false ){
+			K_0 = K_1;
+			iteration(K_1);
+
+			j++;
+			if ( j % 2 == 0 )
+				CC = K_0;
+			if ( j % 4 == 1 )
+				delta = dif_rel(K_1, K_0);
+			if ( j % 4 == 3 and dif_rel(K_1, K_0) >= delta ){
+				flag = divergence_heuristic = true;
+			}
+		} else{
+			iterations = j;
+			throw std::runtime_error("Divergence in nonlinear_diffusion");
+		}
+	}
+	iterations = j;
+}
+
+
+
+template <typename Wunc>
+void NonlinearDiffusion::nonuniform_1_2_newton (const double tau,
+												const double eps, // reletive error for y
+												const double left_bounder_cond, // y(left_border,Time+tau) = left_bounder_cond
+												const double right_bounder_cond, // \frac{y(right_border,Time+tau)}{dx} = right_bounder_cond
+												const Wunc &wunc,
+												const vecd &x, // array with (non)uniform grid
+												vecd &y, // array with initial coundition and for results
+												const double *w_start // w at the start of the step, w(x, y) if it is null
+												){
+	// Maximum number of iterations, Newton method converges quadratically so
+	// it is reached only if the method diverges
+	const int max_iterations = 50;
+	// Maximum relative decrease of y in one iteration
+	const double max_decrease = 0.5;
+
+	const int N = fmin(x.size(), y.size()); // N_x+1
+	prepare(tau, x, N);
+	wunc(x.data(), y.data(), W.data(), 1, N-1);
+	const double *w0 = w_start != nullptr ? w_start : W.data();
+	const double frac_last = ( x[N-1] - x[N-2] ) * ( x[N-1] - x[N-2] ) * 0.5 / tau;
+	for_blocks(1, N-2, [&](const int first, const int last){
+		for ( int i = first; i <= last; ++i ){
+			f[i] = frac[i] * w0[i];
+		}
+	});
+	f[N-1] = frac_last * w0[N-1];
+	y[0] = left_bounder_cond;
+	divergence_heuristic = false;
+
+	// Residuals of the equations are
+	// G_i = a_i y_{i-1} - 2 y_i + b_i y_{i+1} - frac_i W(y_i) + f_i for 0 < i < N-1,
+	// G_{N-1} = y_{N-2} - y_{N-1} - frac_last W(y_{N-1}) + dx right_bounder_cond + f_{N-1},
+	// Jacobian is tridiagonal, so correction is found by the same sweep as in nonuniform_1_2
+	for ( iterations = 1; iterations <= max_iterations; ++iterations ){
+		wunc.derivative(x.data(), y.data(), W.data(), dW.data(), 1, N-1);
+		for_blocks(1, N-2, [&](const int first, const int last){
+			for ( int i = first; i <= last; ++i ){
+				G[i] = a[i] * y[i-1] - 2. * y[i] + b[i] * y[i+1] - frac[i] * W[i] + f[i];
+			}
+		});
+		G[N-1] = y[N-2] - y[N-1] - frac_last * W[N-1] + ( x[N-1] - x[N-2] ) * right_bounder_cond + f[N-1];
+
+		if ( partitioned() ){
+			partitioned_tridiagonal([this](const int i){ return 2. + frac[i] * dW[i]; }, 1. + frac_last * dW[N-1], G.data(), G[N-1], 0., G.data());
+		} else{
+			alpha[1] = 0.;
+			beta[1] = 0.;
+			for ( int i = 1; i < N-1; ++i ){
+				double c = 2. + frac[i] * dW[i];
+				alpha[i+1] = b[i] / ( c - alpha[i] * a[i] );
+				beta[i+1] = ( beta[i] * a[i] + G[i] ) / ( c - alpha[i] * a[i] );
+			}
+			G[N-1] = ( G[N-1] + beta[N-1] ) / ( 1. + frac_last * dW[N-1] - alpha[N-1] );
+			for ( int i = N-2; i > 0; --i ){
+				G[i] = alpha[i+1] * G[i+1] + beta[i+1];
+			}
+		}
+
+		// Damping keeps y positive
+		const double decrease = max_over_blocks(1, N-1, [&](const int first, const int last){
+			double decrease = 0.;
+			for ( int i = first; i <= last; ++i ){
+				decrease = fmax( decrease, - G[i] / y[i] );
+			}
+			return decrease;
+		});
+		const double lambda = decrease > max_decrease ? max_decrease / decrease : 1.;
+		divergence_heuristic = divergence_heuristic or lambda < 1.;
+		const double delta = max_over_blocks(1, N-1, [&](const int first, const int last){
+			double delta = 0.;
+			for ( int i = first; i <= last; ++i ){
+				y[i] += lambda * G[i];
+				delta = fmax( delta, fabs( lambda * G[i] / y[i] ) );
+			}
+			return delta;
+		});
+		residual = delta;
+		if ( not std::isfinite(delta) ){
+			break;
+		}
+		wunc(x.data(), y.data(), W.data(), 1, N-1);
+		if ( delta <= eps ){
+			return;
+		}
+	}
+	throw std::runtime_error("Divergence in nonlinear_diffusion");
+}
+
+
+template <typename Wunc>
+void NonlinearDiffusion::nonuniform_1_2_iterationW (const double tau,
+													const double eps, // reletive error for w
+													const double left_bounder_cond, // y(left_border,Time+tau) = left_bounder_cond
+													const double right_bounder_cond, // \frac{y(right_border,Time+tau)}{dx} = right_bounder_cond
+													const Wunc &wunc,
+													const vecd &x, // array with (non)uniform grid
+													vecd &y, // array with initial coundition and for results
+													const double *w_start // w at the start of the step, w(x, y) if it is null
+													){
+	const int N = fmin(x.size(), y.size()); // N_x+1
+	prepare(tau, x, N);
+	wunc(x.data(), y.data(), W.data(), 1, N-1);
+	const double *w0 = w_start != nullptr ? w_start : W.data();
+	for ( int i = 1; i < N-1; ++i ){
+		f[i] = frac[i] * w0[i];
+		K_1[i] = frac[i] * W[i] / y[i];
+		CC[i] = K_0[i] = K_1[i] * 2. + 10.*eps;
+	}
+	f[N-1] = K_1[N-1] = CC[N-1] = K_0[N-1] = 0.;
+	W_0.assign(N, 0.);
+	W_1.assign(N, 0.);
+	W_CC.assign(N, 0.);
+
+	auto iteration = [&](vecd &K) -> void{ // [&] <-> [&wunc, &x, &y, &frac, &a, &b, &f, N, left_bounder_cond, right_bounder_cond]
+		alpha[1] = 0.;
+		beta[1] = left_bounder_cond;
+		for ( int i = 1; i < N-1; ++i ){
+			double c = 2. + K[i];
+			alpha[i+1] = b[i] / ( c - alpha[i] * a[i] );
+			beta[i+1] = ( beta[i] * a[i] + f[i] ) / ( c - alpha[i] * a[i] );
+		}
+		y[N-1] = ( (x[N-1] - x[N-2] ) * right_bounder_cond + beta[N-1] ) / ( 1. - alpha[N-1] );
+		for ( int i = N-2; i > 0; --i ){
+			y[i] = alpha[i+1] * y[i+1] + beta[i+1];
+		}
+		y[0] = left_bounder_cond;
+		wunc(x.data(), y.data(), W.data(), 1, N-1);
+		for ( int i = 1; i < N-1; ++i ){
+			K[i] = frac[i] * W[i] / y[i];
+		}
+	};
+
+	bool flag = false;	int j = 0;	double delta;
+	for (int i = 1; i < N-1; ++i){
+		W_0[i] = W[i];
+		W_1[i] = W[i] + eps*2.;
+	}
+	divergence_heuristic = false;
+	while( ( residual = max_dif_rel(W_1, W_0, 1, N-2) ) > eps ){
+		if ( max_dif_rel(W_1, W_CC, 1, N-2) > 0. and flag == false ){
+			W_0 = W_1;
+			iteration(K_1);
+			for (int i = 1; i < N-1; ++i){
+				W_1[i] = K_1[i] / frac[i] * y[i];
+ 			}
+			j++;
+			if ( j % 2 == 0 ){
+				W_CC = K_0;
+			}
+			if ( j % 4 == 1 ){
+				delta = max_dif_rel (W_1, W_0, 1, N-2);
+			}
+			if ( j % 4 == 3 and max_dif_rel (W_1, W_0, 1, N-2) >= delta ){
+				flag = divergence_heuristic = true;
+			}
+		} else{
+			iterations = j;
+			throw std::runtime_error("Divergence in nonlinear_diffusion");
+		}
+	}
+	iterations = j;
+}
+
+
+
+template <typename Wunc>
+void NonlinearDiffusion::nonuniform_2_2 (const double tau,
+										 const double eps, // reletive error for w
+										 const double left_bounder_cond, // // \frac{y(left_border,Time+tau)}{dx} = left_bounder_cond
+										 const double right_bounder_cond, // \frac{y(right_border,Time+tau)}{dx} = right_bounder_cond
+										 const Wunc &wunc,
+										 const vecd &x, // array with (non)uniform grid
+										 vecd &y, // array with initial coundition and for results
+										 const double *w_start // w at the start of the step, w(x, y) if it is null
+									 	){
+	const int N = fmin(x.size(), y.size()); // N_x+1
+	prepare(tau, x, N);
+	wunc(x.data(), y.data(), W.data(), 1, N-1);
+	const double *w0 = w_start != nullptr ? w_start : W.data();
+	for ( int i = 1; i < N-1; ++i ){
+		f[i] = frac[i] * w0[i];
+		K_1[i] = frac[i] * W[i] / y[i];
+		CC[i] = K_0[i] = K_1[i] * 2. + 10.*eps;
+	}
+	f[N-1] = K_1[N-1] = CC[N-1] = K_0[N-1] = 0.;
+
+	auto iteration = [&](vecd &K) -> void{ // [&] <-> [&wunc, &x, &y, &frac, &a, &b, &f, N, left_bounder_cond, right_bounder_cond]
+		alpha[1] = 1.;
+		beta[1] = - (x[1] - x[0]) * left_bounder_cond;
+		for ( int i = 1; i < N-1; ++i ){
+			double c = 2. + K[i];
+			alpha[i+1] = b[i] / ( c - alpha[i] * a[i] );
+			beta[i+1] = ( beta[i] * a[i] + f[i] ) / ( c - alpha[i] * a[i] );
+		}
+		y[N-1] = ( (x[N-1] - x[N-2] ) * right_bounder_cond + beta[N-1] ) / ( 1. - alpha[N-1] );
+		for ( int i = N-2; i > 0; --i )
+			y[i] = alpha[i+1] * y[i+1] + beta[i+1];
+		y[0] = left_bounder_cond;
+		wunc(x.data(), y.data(), W.data(), 1, N-1);
+		for ( int i = 1; i < N-1; ++i )
+			K[i] = frac[i] * W[i] / y[i];
+	};
+
+	bool flag = false;	int j = 0;	double delta;
+	divergence_heuristic = false;
+	while( ( residual = max_dif_rel(K_1, K_0, 1, N-2) ) > eps ){
+		if ( max_dif_rel(K_1, CC, 1, N-2) > 0. and flag == false ){
+			K_0 = K_1;
+			iteration(K_1);
+
+			j++;
+			if ( j % 2 == 0 )
+				CC = K_0;
+			if ( j % 4 == 1 )
+				delta = max_dif_rel (K_1, K_0, 1, N-2);
+			if ( j % 4 == 3 and max_dif_rel (K_1, K_0, 1, N-2) >= delta ){
+				flag = divergence_heuristic = true;
+			}
+		} else{
+			iterations = j;
+			throw std::runtime_error("Divergence in nonlinear_diffusion");
+		}
+	}
+	iterations = j;
+}
+
+
+// Functions below use temporary NonlinearDiffusion object, use it directly to avoid reallocations
 
-// \frac{dw}{dt}=\frac{d^2y}{dx^2}, y=y(x,t) — ?, w = w (x,y)
 void nonlenear_diffusion_nonuniform_1_2 (const double tau,
 										 const double eps, // reletive error for w
 										 const double left_bounder_cond, // y(left_border,Time+tau) = left_bounder_cond
 										 const double right_bounder_cond, // \frac{y(right_border,Time+tau)}{dx} = right_bounder_cond
-										 std::function<vecd (const vecd &, const vecd &, unsigned int, unsigned int)> wunc, // first argument is array of x_i, second — array of y(x_i,t); return value — array of w(x_i,y_i)
+										 const wunc_t &wunc,
 										 const vecd &x, // array with (non)uniform grid
 										 vecd &y// array with initial coundition and for results
 									 	);
@@ -31,7 +605,7 @@ void nonlenear_diffusion_nonuniform_1_2_iterationW (const double tau,
 										const double eps, // reletive error for w
 										const double left_bounder_cond, // y(left_border,Time+tau) = left_bounder_cond
 										const double right_bounder_cond, // \frac{y(right_border,Time+tau)}{dx} = right_bounder_cond
-										std::function<vecd (const vecd &, const vecd &, unsigned int, unsigned int)> wunc, // first argument is array of x_i, second — array of y(x_i,t); return value — array of w(x_i,y_i)
+										const wunc_t &wunc,
 										const vecd &x, // array with (non)uniform grid
 										vecd &y// array with initial coundition and for results
 										);
@@ -41,7 +615,7 @@ void nonlenear_diffusion_nonuniform_2_2 (const double tau,
 										 const double eps, // reletive error for w
 										 const double left_bounder_cond, // \frac{y(left_border,Time+tau)}{dx} = left_bounder_cond
 										 const double right_bounder_cond, // \frac{y(right_border,Time+tau)}{dx} = right_bounder_cond
-										 std::function<vecd (const vecd &, const vecd &, unsigned int, unsigned int)> wunc, // first argument is array of x_i, second — array of y(x_i,t); return value — array of w(x_i,y_i)
+										 const wunc_t &wunc,
 										 const vecd &x, // array with (non)uniform grid
 										 vecd &y// array with initial coundition and for results
 									 	);
@@ -5,7 +5,8 @@ OpacityRelated::OpacityRelated(
 	const std::string &opacity_type,
 	double Mx,
 	double alpha,
-	double mu
+	double mu,
+	const std::string &table_filename
 ) throw(std::invalid_argument):
 	type(opacity_type),
 	Mx(Mx),
@@ -18,6 +19,8 @@ OpacityRelated::OpacityRelated(
 		init_Kramers();
 	} else if ( type == "OPAL" ){
 		init_OPAL();
+	} else if ( type == "table" ){
+		init_table(table_filename);
 	} else{
 		throw std::invalid_argument(opacity_type);
 	}
@@ -82,11 +85,24 @@ void OpacityRelated::init_OPAL(){
 }
 
 
-double OpacityRelated::Height(double R, double F){
+void OpacityRelated::init_table(const std::string &table_filename){
+	if ( table_filename.empty() ){
+		throw std::invalid_argument("Opacity table file is required for tabulated opacity");
+	}
+	init_OPAL();
+	structure = std::make_shared<VerticalStructureTable>(RosselandOpacityTable(table_filename), GM, alpha, mu, Pi1, Pi2, Pi3, Pi4);
+	structure->fit_power_law(m, n, D);
+}
+
+
+double OpacityRelated::Height(double R, double F) const{
+	if ( structure ){
+		return structure->Height(structure->row(sqrt(GM * R)), F);
+	}
 	return R * Height_coef * pow(F, Height_exp_F) * pow(R/1e10, Height_exp_R - Height_exp_F/2.);
 }
 
 
-double OpacityRelated::f_F(double xi){
+double OpacityRelated::f_F(double xi) const{
 	return a0 * xi + a1 * pow(xi, k) + a2 * pow(xi, l);
 }
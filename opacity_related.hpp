@@ -5,36 +5,45 @@
 #include <algorithm> // std::none_of
 #include <array>
 #include <cmath>
+#include <memory>
 #include <stdexcept> // std::invalid_argument
 #include <string>
 
 #include "gsl_const_cgsm.h"
+#include "opacity_table.hpp"
 
 
 class OpacityRelated{
 private:
 	void init_Kramers();
 	void init_OPAL();
+	void init_table(const std::string &table_filename);
 
 public:
 	OpacityRelated(
 		const std::string &opacity_type,
 		double Mx,
 		double alpha,
-		double mu
+		double mu,
+		const std::string &table_filename = ""
 	) throw(std::invalid_argument);
 	~OpacityRelated(){};
 
-	const std::array<std::string, 2> supported_types {{ "Kramers", "OPAL" }};
+	const std::array<std::string, 3> supported_types {{ "Kramers", "OPAL", "table" }};
 	const std::string type;
 
 	const double Mx, alpha, mu;
 	double GM;
 	double m, n, varkappa0, Pi1, Pi2, Pi3, Pi4, Pi_Sigma, Pi_Height, D, Height_exp_F, Height_exp_R, Height_coef;
 	double a0, a1, a2, k, l;
-
-	double Height(double R, double F);
-	double f_F(double xi);
+	// Vertical structure for tabulated opacity, it is null for Kramers and
+	// OPAL laws. For the table m, n and D are parameters of the power law
+	// fitted to W, other parameters are the same as for OPAL law and are used
+	// by initial conditions only
+	std::shared_ptr<const VerticalStructureTable> structure;
+
+	double Height(double R, double F) const;
+	double f_F(double xi) const;
 };
 
 
@@ -0,0 +1,318 @@
+#include "opacity_table.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "gsl_const_cgsm.h"
+#include "simd_math.hpp"
+
+
+using namespace std;
+
+
+RosselandOpacityTable::RosselandOpacityTable(const string &filename){
+	ifstream input(filename);
+	if ( not input ){
+		throw invalid_argument("Cannot open opacity table file " + filename);
+	}
+	string line;
+	while ( getline(input, line) ){
+		istringstream tokens(line);
+		string label;
+		if ( not (tokens >> label) or label.front() == '#' ){
+			continue;
+		}
+		vector<double> values;
+		double x;
+		while ( tokens >> x ){
+			values.push_back(x);
+		}
+		if ( not tokens.eof() ){
+			throw invalid_argument("Wrong line in opacity table file " + filename + ": " + line);
+		}
+		if ( log_R.empty() ){
+			log_R = values;
+			if ( log_R.empty() ){
+				throw invalid_argument("The first line of opacity table file " + filename + " should contain log R values");
+			}
+			continue;
+		}
+		if ( values.empty() or values.size() > log_R.size() ){
+			throw invalid_argument("Wrong number of values in opacity table file " + filename + ": " + line);
+		}
+		log_T.push_back(stod(label));
+		values.resize(log_R.size(), values.back());
+		log_kappa.insert(log_kappa.end(), values.begin(), values.end());
+	}
+	*this = RosselandOpacityTable(log_T, log_R, log_kappa);
+}
+
+
+RosselandOpacityTable::RosselandOpacityTable(const vector<double> &log_T, const vector<double> &log_R, const vector<double> &log_kappa):
+	log_T(log_T), log_R(log_R), log_kappa(log_kappa)
+{
+	if ( log_T.size() < 2 or log_R.size() < 2 or log_kappa.size() != log_T.size() * log_R.size() ){
+		throw invalid_argument("Opacity table should have at least two values of log T and log R");
+	}
+	if ( not is_sorted(log_T.begin(), log_T.end()) or not is_sorted(log_R.begin(), log_R.end()) ){
+		throw invalid_argument("log T and log R of opacity table should be sorted");
+	}
+}
+
+
+double RosselandOpacityTable::T_min() const{
+	return pow(10., log_T.front());
+}
+
+
+double RosselandOpacityTable::T_max() const{
+	return pow(10., log_T.back());
+}
+
+
+// Index of the left node and weight of the right node, the weight is in [0, 1]
+static void bracket(const vector<double> &nodes, const double x, size_t &j, double &p){
+	j = upper_bound(nodes.begin() + 1, nodes.end() - 1, x) - nodes.begin() - 1;
+	p = ( x - nodes[j] ) / ( nodes[j+1] - nodes[j] );
+	p = p < 0. ? 0. : ( p > 1. ? 1. : p );
+}
+
+
+bool RosselandOpacityTable::contains(const double rho, const double T) const{
+	const double lg_T = log10(T);
+	const double lg_R = log10(rho) - 3. * (lg_T - 6.);
+	return lg_T >= log_T.front() and lg_T <= log_T.back() and lg_R >= log_R.front() and lg_R <= log_R.back();
+}
+
+
+double RosselandOpacityTable::operator()(const double rho, const double T) const{
+	const double lg_T = log10(T);
+	const double lg_R = log10(rho) - 3. * (lg_T - 6.);
+	size_t j, k;
+	double p, q;
+	bracket(log_T, lg_T, j, p);
+	bracket(log_R, lg_R, k, q);
+	const size_t N_R = log_R.size();
+	const double lower = log_kappa[j*N_R + k] + q * ( log_kappa[j*N_R + k+1] - log_kappa[j*N_R + k] );
+	const double upper = log_kappa[(j+1)*N_R + k] + q * ( log_kappa[(j+1)*N_R + k+1] - log_kappa[(j+1)*N_R + k] );
+	return pow(10., lower + p * (upper - lower));
+}
+
+
+VerticalStructureTable::VerticalStructureTable(const RosselandOpacityTable &kappa, const double GM, const double alpha, const double mu, const double Pi1, const double Pi2, const double Pi3, const double Pi4){
+	const double R_min = 1e6, R_max = 1e13;
+	const double F_min = 1e24, F_max = 1e44;
+	ln_h_first = 0.5 * log(GM * R_min);
+	step_ln_h = 0.025 * M_LN10;
+	N_h = static_cast<int>( ceil( 0.5 * log(R_max / R_min) / step_ln_h ) ) + 1;
+	ln_F_first = log(F_min);
+	step_ln_F = 0.02 * M_LN10;
+	N_F = static_cast<int>( ceil( log(F_max / F_min) / step_ln_F ) ) + 1;
+	ln_W.resize(N_h * N_F);
+	ln_Height.resize(N_h * N_F);
+
+	// c_s^2 / T
+	const double cs2_T = GSL_CONST_CGSM_BOLTZMANN / (mu * GSL_CONST_CGSM_MASS_PROTON);
+	const double ln_T_top = log(kappa.T_max()) + M_LN10;
+	const double ln_T_bottom = log(kappa.T_min());
+	const double step_scan = 0.25;
+
+	// Normal equations for power law fit ln W = c0 + c1 (ln F - ln_F_mid) + c2 (ln h - ln_h_mid)
+	// over points where the solution is inside of the opacity table
+	const double ln_F_mid = ln_F_first + 0.5 * step_ln_F * (N_F - 1);
+	const double ln_h_mid = ln_h_first + 0.5 * step_ln_h * (N_h - 1);
+	double A[3][3] = {{0.}}, b[3] = {0.};
+
+	for ( int j = 0; j < N_h; ++j ){
+		const double ln_h = ln_h_first + step_ln_h * j;
+		const double h = exp(ln_h);
+		const double R = h * h / GM;
+		const double omega = GM * GM / (h * h * h);
+		// The hottest solution is searched downwards in T. It decreases
+		// with F, so the search for the next F starts from the previous one
+		double ln_T_start = ln_T_top;
+		for ( int k = N_F - 1; k >= 0; --k ){
+			const double ln_F = ln_F_first + step_ln_F * k;
+			const double F = exp(ln_F);
+			const double T_eff4 = 3. * F * omega / (8. * M_PI * GSL_CONST_CGSM_STEFAN_BOLTZMANN_CONSTANT * R * R);
+			double Sigma_0, z_0, rho_c;
+			// Ketsaris & Shakura (1998) relations with constant Pi1..Pi4,
+			// the residual is ln(T_c^4 of the radiative transfer) - ln(T_c^4)
+			const auto residual = [&](const double ln_T){
+				const double T = exp(ln_T);
+				Sigma_0 = Pi3 * F / (2. * M_PI * R * R * alpha * cs2_T * T);
+				z_0 = sqrt(Pi1 * cs2_T * T) / omega;
+				rho_c = Sigma_0 / (2. * z_0 * Pi2);
+				return log( 3./32. * T_eff4 * Sigma_0 * kappa(rho_c, T) / Pi4 ) - 4. * ln_T;
+			};
+
+			double ln_T = ln_T_start;
+			double g_hot = residual(ln_T);
+			bool found = false;
+			if ( g_hot < 0. ){
+				double ln_T_hot = ln_T;
+				double g = g_hot;
+				while ( ln_T > ln_T_bottom ){
+					ln_T = fmax(ln_T - step_scan, ln_T_bottom);
+					g = residual(ln_T);
+					if ( g >= 0. ){
+						break;
+					}
+					ln_T_hot = ln_T;
+					g_hot = g;
+				}
+				// Illinois method in [ln_T, ln_T_hot]
+				double ln_T_cold = ln_T;
+				double g_cold = g;
+				int side = 0;
+				for ( int iter = 0; g_cold >= 0. and iter < 100 and ln_T_hot - ln_T_cold > 1e-12; ++iter ){
+					ln_T = ( ln_T_cold * g_hot - ln_T_hot * g_cold ) / ( g_hot - g_cold );
+					g = residual(ln_T);
+					if ( fabs(g) < 1e-12 ){
+						break;
+					}
+					if ( g > 0. ){
+						ln_T_cold = ln_T;
+						g_cold = g;
+						if ( side == -1 ) g_hot *= 0.5;
+						side = -1;
+					} else{
+						ln_T_hot = ln_T;
+						g_hot = g;
+						if ( side == 1 ) g_cold *= 0.5;
+						side = 1;
+					}
+				}
+				found = g_cold >= 0.;
+				residual(ln_T);
+			}
+			ln_T_start = ln_T;
+
+			// Normalisation of W is the same as for analytic laws
+			ln_W[j*N_F + k] = log( 4. * M_PI * h * h * h * Sigma_0 / (GM * GM) );
+			ln_Height[j*N_F + k] = log(z_0);
+
+			if ( found and kappa.contains(rho_c, exp(ln_T)) ){
+				const double x[3] = { 1., ln_F - ln_F_mid, ln_h - ln_h_mid };
+				for ( int a = 0; a < 3; ++a ){
+					for ( int c = 0; c < 3; ++c ){
+						A[a][c] += x[a] * x[c];
+					}
+					b[a] += x[a] * ln_W[j*N_F + k];
+				}
+			}
+		}
+	}
+
+	const auto det = [](const double M[3][3]){
+		return M[0][0] * (M[1][1]*M[2][2] - M[1][2]*M[2][1])
+			- M[0][1] * (M[1][0]*M[2][2] - M[1][2]*M[2][0])
+			+ M[0][2] * (M[1][0]*M[2][1] - M[1][1]*M[2][0]);
+	};
+	if ( A[0][0] < 3. or det(A) <= 0. ){
+		throw std::invalid_argument("Opacity table doesn't cover conditions of the disc");
+	}
+	double c[3];
+	for ( int a = 0; a < 3; ++a ){
+		double M[3][3];
+		for ( int r = 0; r < 3; ++r ){
+			for ( int s = 0; s < 3; ++s ){
+				M[r][s] = s == a ? b[r] : A[r][s];
+			}
+		}
+		c[a] = det(M) / det(A);
+	}
+	fit_m = 1. - c[1];
+	fit_n = c[2];
+	fit_D = exp( -(c[0] - c[1] * ln_F_mid - c[2] * ln_h_mid) ) / (1. - fit_m);
+}
+
+
+double VerticalStructureTable::row(const double h) const{
+	return ( log(h) - ln_h_first ) / step_ln_h;
+}
+
+
+// Bilinear interpolation of the table in row and u = (ln F - ln_F_first) / step_ln_F,
+// slope is the derivative over u. It is branch-free, so it can be used in
+// vectorised loops
+inline static double interpolate(const double * __restrict table, const int N_h, const int N_F, const double row, const double u, double &slope){
+	const double row_last = N_h - 2.;
+	const double u_last = N_F - 2.;
+	const int j = static_cast<int>( row < 0. ? 0. : ( row > row_last ? row_last : row ) );
+	const int k = static_cast<int>( u < 0. ? 0. : ( u > u_last ? u_last : u ) );
+	const double p = row - j;
+	const double q = u - k;
+	const int index = j * N_F + k;
+	const double lower_0 = table[index];
+	const double lower_1 = table[index + 1];
+	const double upper_0 = table[index + N_F];
+	const double upper_1 = table[index + N_F + 1];
+	slope = ( lower_1 - lower_0 ) + p * ( ( upper_1 - upper_0 ) - ( lower_1 - lower_0 ) );
+	const double value_lower = lower_0 + q * ( lower_1 - lower_0 );
+	const double value_upper = upper_0 + q * ( upper_1 - upper_0 );
+	return value_lower + p * ( value_upper - value_lower );
+}
+
+
+FREDDI_TARGET_CLONES
+static void interpolate_exp(const double * __restrict table, const int N_h, const int N_F, const double ln_F_first, const double step_ln_F, const double * __restrict row, const double * __restrict F, double * __restrict y, const int first, const int last){
+	#pragma omp simd
+	for ( int i = first; i <= last; ++i ){
+		const double u = ( log_simd(F[i]) - ln_F_first ) / step_ln_F;
+		double slope;
+		const double ln_y = interpolate(table, N_h, N_F, row[i], u, slope);
+		y[i] = F[i] > 0. ? exp_simd(ln_y) : 0.;
+	}
+}
+
+
+FREDDI_TARGET_CLONES
+static void interpolate_derivative(const double * __restrict table, const int N_h, const int N_F, const double ln_F_first, const double step_ln_F, const double * __restrict row, const double * __restrict F, const double * __restrict y, double * __restrict dy, const int first, const int last){
+	#pragma omp simd
+	for ( int i = first; i <= last; ++i ){
+		const double u = ( log_simd(F[i]) - ln_F_first ) / step_ln_F;
+		double slope;
+		interpolate(table, N_h, N_F, row[i], u, slope);
+		dy[i] = F[i] > 0. ? slope / step_ln_F * y[i] / F[i] : 0.;
+	}
+}
+
+
+double VerticalStructureTable::W(const double row, const double F) const{
+	double W_value;
+	interpolate_exp(ln_W.data(), N_h, N_F, ln_F_first, step_ln_F, &row, &F, &W_value, 0, 0);
+	return W_value;
+}
+
+
+double VerticalStructureTable::Height(const double row, const double F) const{
+	double Height_value;
+	interpolate_exp(ln_Height.data(), N_h, N_F, ln_F_first, step_ln_F, &row, &F, &Height_value, 0, 0);
+	return Height_value;
+}
+
+
+void VerticalStructureTable::W(const double *row, const double *F, double *W, const int first, const int last) const{
+	interpolate_exp(ln_W.data(), N_h, N_F, ln_F_first, step_ln_F, row, F, W, first, last);
+}
+
+
+void VerticalStructureTable::dWdF(const double *row, const double *F, const double *W, double *dWdF, const int first, const int last) const{
+	interpolate_derivative(ln_W.data(), N_h, N_F, ln_F_first, step_ln_F, row, F, W, dWdF, first, last);
+}
+
+
+void VerticalStructureTable::Height(const double *row, const double *F, double *Height, const int first, const int last) const{
+	interpolate_exp(ln_Height.data(), N_h, N_F, ln_F_first, step_ln_F, row, F, Height, first, last);
+}
+
+
+void VerticalStructureTable::fit_power_law(double &m, double &n, double &D) const{
+	m = fit_m;
+	n = fit_n;
+	D = fit_D;
+}
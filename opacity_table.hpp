@@ -0,0 +1,72 @@
+#ifndef _OPACITY_TABLE_HPP
+#define _OPACITY_TABLE_HPP
+
+
+#include <string>
+#include <vector>
+
+
+// Rosseland mean opacity varkappa(rho, T) tabulated over log T and
+// log R = log rho - 3 log T6, where T6 = T / 1e6 K, like OPAL tables. Both
+// axes may be non-uniform. Interpolation is bilinear in logarithms,
+// values outside of the table are taken from its edge
+class RosselandOpacityTable{
+private:
+	std::vector<double> log_T, log_R;
+	// log varkappa, row of log_R.size() values for every log_T
+	std::vector<double> log_kappa;
+
+public:
+	// Text file: the first line is a label (e.g. logT) followed by log R
+	// values, every next line is log T followed by log varkappa for every
+	// log R. Missing values at the end of a row are taken equal to the last
+	// value of the row. Empty lines and lines started with # are ignored
+	explicit RosselandOpacityTable(const std::string &filename);
+	RosselandOpacityTable(const std::vector<double> &log_T, const std::vector<double> &log_R, const std::vector<double> &log_kappa);
+
+	double T_min() const;
+	double T_max() const;
+	bool contains(double rho, double T) const;
+	// varkappa, cm^2/g
+	double operator()(double rho, double T) const;
+};
+
+
+// Vertical structure of the disc for tabulated opacity is calculated once
+// on the uniform grid of ln h and ln F, and the solver interpolates it.
+// Central temperature is found from relations of Ketsaris & Shakura (1998)
+// between central and surface values with given Pi1..Pi4 constants, i.e.
+// the table with power-law opacity gives the same W as analytic law with
+// the same Pi constants. The hottest solution is taken if there are several
+// ones. Tables contain ln W and ln Height, they are bilinear in ln h and
+// ln F and are extrapolated linearly outside of the grid, i.e. as power laws
+class VerticalStructureTable{
+private:
+	double ln_h_first, step_ln_h, ln_F_first, step_ln_F;
+	int N_h, N_F;
+	// N_h rows of N_F values
+	std::vector<double> ln_W, ln_Height;
+	double fit_m, fit_n, fit_D;
+
+public:
+	// Grid covers radii from 1e6 to 1e13 cm and F from 1e24 to 1e44 dyn*cm
+	VerticalStructureTable(const RosselandOpacityTable &kappa, double GM, double alpha, double mu, double Pi1, double Pi2, double Pi3, double Pi4);
+
+	// Fractional row number of h, it depends on the radial grid only and is
+	// calculated once per point, see GridFactors
+	double row(double h) const;
+
+	double W(double row, double F) const;
+	double Height(double row, double F) const;
+	// The same for first <= i <= last, W and dW/dF for Newton solver
+	void W(const double *row, const double *F, double *W, int first, int last) const;
+	void dWdF(const double *row, const double *F, const double *W, double *dWdF, int first, int last) const;
+	void Height(const double *row, const double *F, double *Height, int first, int last) const;
+
+	// Least squares fit of the table by power law W = F^(1-m) h^n / (1-m) / D
+	// over points where the disc is inside of the opacity table
+	void fit_power_law(double &m, double &n, double &D) const;
+};
+
+
+#endif // _OPACITY_TABLE_HPP
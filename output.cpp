@@ -0,0 +1,290 @@
+#include "output.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+
+using namespace std;
+
+
+void write_summary_header(ostream &output, const vector<string> &bands, const string &first_names, const string &first_units){
+	output << "#" << first_names << "t    Mdot Lx    H2R   Rhot Tphout Mdisk kxout Qiir2Qvisout";
+	// Columns are aligned like "mU  mB  mV", units are "mag mag mag"
+	for ( const auto &band : bands ){
+		output << " m" << band << string( band.size() < 2 ? 2 - band.size() : 0, ' ' );
+	}
+	output << " Niter tau" << "\n";
+	output << "#" << first_units << "days g/s  erg/s float Rsun K      g     float float       ";
+	for ( const auto &band : bands ){
+		output << " mag" << string( band.size() > 2 ? band.size() - 2 : 0, ' ' );
+	}
+	output << " int   days" << "\n";
+}
+
+
+void write_summary_row(ostream &output, const FreddiSummary &s){
+	output		<< s.t / DAY
+		<< "\t" << s.Mdot_in
+		<< "\t" << s.Lx
+		<< "\t" << s.H2R
+		<< "\t" << s.Rhot / solar_radius
+		<< "\t" << s.Tphout
+		<< "\t" << s.Mdisk
+		<< "\t" << s.kxout
+		<< "\t" << s.Qirr2Qvisout;
+	for ( const double m : s.m ){
+		output << "\t" << m;
+	}
+	output	<< "\t" << s.Niter
+		<< "\t" << s.tau / DAY;
+}
+
+
+double summary_column(const FreddiSummary &s, const vector<string> &bands, const string &name){
+	const vector<pair<string, double>> columns = {
+		{"Mdot", s.Mdot_in}, {"Lx", s.Lx}, {"H2R", s.H2R}, {"Rhot", s.Rhot / solar_radius},
+		{"Tphout", s.Tphout}, {"Mdisk", s.Mdisk}, {"kxout", s.kxout}, {"Qiir2Qvisout", s.Qirr2Qvisout},
+	};
+	for ( const auto &column : columns ){
+		if ( name == column.first ){
+			return column.second;
+		}
+	}
+	for ( size_t i = 0; i < bands.size(); ++i ){
+		if ( name == "m" + bands[i] ){
+			return s.m[i];
+		}
+	}
+	throw invalid_argument("Unknown column " + name);
+}
+
+
+OutputSchedule::OutputSchedule(const FreddiEvolution &freddi):
+	every(freddi.args.output_every),
+	times(freddi.args.output_times),
+	next_time(0)
+{
+	const FreddiArguments &args = freddi.args;
+	if ( args.output_per_decade > 0. ){
+		times.push_back(0.);
+		for ( int i = 0; ; ++i ){
+			const double t = args.tau * pow( 10., i / args.output_per_decade );
+			if ( t > args.Time ){
+				break;
+			}
+			times.push_back(t);
+		}
+		sort(times.begin(), times.end());
+	}
+	if ( not args.restart_filename.empty() ){
+		next_time = upper_bound(times.begin(), times.end(), freddi.t + 1e-6 * freddi.tau) - times.begin();
+	}
+}
+
+
+bool OutputSchedule::due(const FreddiEvolution &freddi){
+	bool output = every > 0 and freddi.i_t % every == 0;
+	// Times of fixed steps are accumulated with rounding errors
+	const double rounding = 1e-6 * freddi.tau;
+	for ( ; next_time < times.size() and freddi.t >= times[next_time] - rounding; ++next_time ){
+		output = true;
+	}
+	return output;
+}
+
+
+TelemetryFile::TelemetryFile(const string &filename):
+	output(filename),
+	start(chrono::steady_clock::now()),
+	steps(0), iterations(0), max_iterations(0), heuristic_steps(0),
+	max_residual(0.)
+{
+	output << "#i_t t    tau  Niter residual heuristic solve wunc spectrum photometry output" << "\n";
+	output << "#int days days int   float    bool      s     s    s        s          s" << endl;
+}
+
+
+TelemetryFile::~TelemetryFile(){
+	const double wall = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	const int n = max(steps, 1);
+	output << "# Steps: " << steps << ", wall time: " << wall << " s" << "\n";
+	output << "# Solver iterations: " << iterations << ", mean " << double(iterations) / n << ", max " << max_iterations << "\n";
+	output << "# Maximum final residual: " << max_residual << "\n";
+	output << "# Divergence heuristic fired in " << heuristic_steps << " steps" << "\n";
+	output << "# part       total_s  mean_s   share" << "\n";
+	const double other = wall - total.solve - total.spectrum - total.photometry - total.output;
+	const vector<pair<string, double>> parts = {
+		{"solve", total.solve}, {"wunc", total.wunc}, {"spectrum", total.spectrum},
+		{"photometry", total.photometry}, {"output", total.output}, {"other", other},
+	};
+	for ( const auto &part : parts ){
+		output << "# " << part.first << string(11 - part.first.size(), ' ') << part.second << "\t" << part.second / n << "\t" << part.second / wall << "\n";
+	}
+	output << "# wunc is a part of solve" << endl;
+}
+
+
+void TelemetryFile::write(const FreddiEvolution &freddi, const double output_seconds){
+	const StepTelemetry &step = freddi.telemetry;
+	output		<< freddi.i_t
+		<< "\t" << freddi.t / DAY
+		<< "\t" << freddi.tau / DAY
+		<< "\t" << freddi.Niter
+		<< "\t" << step.residual
+		<< "\t" << step.divergence_heuristic
+		<< "\t" << step.solve
+		<< "\t" << step.wunc
+		<< "\t" << step.spectrum
+		<< "\t" << step.photometry
+		<< "\t" << output_seconds
+		<< "\n";
+
+	++steps;
+	iterations += freddi.Niter;
+	max_iterations = max(max_iterations, freddi.Niter);
+	heuristic_steps += step.divergence_heuristic;
+	max_residual = fmax(max_residual, step.residual);
+	total.solve += step.solve;
+	total.wunc += step.wunc;
+	total.spectrum += step.spectrum;
+	total.photometry += step.photometry;
+	total.output += output_seconds;
+}
+
+
+// Yields a few times and then sleeps, it is used to wait for the other thread
+static void wait_for_other_thread(int &attempt){
+	if ( attempt++ < 100 ){
+		this_thread::yield();
+	} else{
+		this_thread::sleep_for(chrono::microseconds(100));
+	}
+}
+
+
+FreddiFileOutput::FreddiFileOutput(const FreddiEvolution &freddi, const string &cmdline):
+	freddi(freddi),
+	output_sum(freddi.args.output_dir + "/" + freddi.args.filename_prefix + ".dat"),
+	output_seconds(0.),
+	queue(queue_size),
+	free_snapshots(queue_size),
+	done(false)
+{
+	write_summary_header(output_sum, freddi.photometry.names());
+	output_sum << "# r_out = " << freddi.args.r_out << "\n";
+	output_sum << "#" << cmdline << endl;
+
+	if ( not freddi.args.observation_times.empty() ){
+		output_obs.open(freddi.args.output_dir + "/" + freddi.args.filename_prefix + "_obs.dat");
+		write_summary_header(output_obs, freddi.photometry.names());
+		output_obs << "# r_out = " << freddi.args.r_out << "\n";
+		output_obs << "#" << cmdline << endl;
+	}
+
+	if ( freddi.args.telemetry ){
+		telemetry.reset(new TelemetryFile(freddi.args.output_dir + "/" + freddi.args.filename_prefix + "_telemetry.dat"));
+	}
+
+	if ( freddi.args.output_fulldata and freddi.args.fulldata_format == "binary" ){
+		fulldata_binary.reset(new FulldataBinaryWriter(freddi.args.output_dir + "/" + freddi.args.filename_prefix + "_fulldata.bin"));
+	} else if ( freddi.args.output_fulldata and freddi.args.fulldata_format != "text" ){
+		throw invalid_argument(freddi.args.fulldata_format);
+	}
+
+	for ( int i = 0; i < queue_size; ++i ){
+		snapshots.emplace_back(new OutputSnapshot);
+		free_snapshots.push(snapshots.back().get());
+	}
+	writer = thread(&FreddiFileOutput::write_loop, this);
+}
+
+
+FreddiFileOutput::~FreddiFileOutput(){
+	done.store(true, memory_order_release);
+	writer.join();
+}
+
+
+void FreddiFileOutput::dump(){
+	ScopedTimer timer(telemetry ? &output_seconds : nullptr);
+	OutputSnapshot *snapshot;
+	for ( int attempt = 0; not free_snapshots.pop(snapshot); ){
+		wait_for_other_thread(attempt);
+	}
+
+	freddi.summary(snapshot->summary);
+	if ( freddi.args.output_fulldata ){
+		snapshot->i_t = freddi.i_t;
+		snapshot->t = freddi.t;
+		snapshot->Mdot_in = freddi.Mdot_in;
+		const array<const vecd *, fulldata_columns> columns {{ &freddi.h, &freddi.R, &freddi.F, &freddi.Sigma, &freddi.Tph, &freddi.Tph_vis, &freddi.Height }};
+		for ( int c = 0; c < fulldata_columns; ++c ){
+			snapshot->columns[c].assign(columns[c]->begin() + 1, columns[c]->begin() + freddi.Nx);
+		}
+	}
+
+	// Number of snapshots equals to the queue size, so it is never full
+	queue.push(snapshot);
+}
+
+
+void FreddiFileOutput::dump_observations(){
+	ScopedTimer timer(telemetry ? &output_seconds : nullptr);
+	for ( const auto &s : freddi.observations ){
+		write_summary_row(output_obs, s);
+		output_obs << endl;
+	}
+}
+
+
+void FreddiFileOutput::dump_telemetry(){
+	if ( telemetry ){
+		telemetry->write(freddi, output_seconds);
+		output_seconds = 0.;
+	}
+}
+
+
+void FreddiFileOutput::write(const OutputSnapshot &snapshot){
+	if ( freddi.args.output_fulldata ){
+		array<const double *, fulldata_columns> columns;
+		for ( int c = 0; c < fulldata_columns; ++c ){
+			columns[c] = snapshot.columns[c].data();
+		}
+		const uint64_t N = snapshot.columns[0].size();
+		if ( fulldata_binary ){
+			fulldata_binary->write(snapshot.i_t, snapshot.t, snapshot.Mdot_in, N, columns.data());
+		} else{
+			ostringstream filename;
+			filename << freddi.args.output_dir << "/" << freddi.args.filename_prefix << "_" << snapshot.i_t << ".dat";
+			ofstream output(filename.str());
+			write_fulldata_text(output, snapshot.t, snapshot.Mdot_in, N, columns.data());
+		}
+	}
+
+	write_summary_row(output_sum, snapshot.summary);
+	output_sum << "\n";
+}
+
+
+void FreddiFileOutput::write_loop(){
+	for ( int attempt = 0; ; wait_for_other_thread(attempt) ){
+		// Snapshots pushed before done is set are written before exit
+		const bool finished = done.load(memory_order_acquire);
+		OutputSnapshot *snapshot;
+		while ( queue.pop(snapshot) ){
+			write(*snapshot);
+			free_snapshots.push(snapshot);
+			attempt = 0;
+		}
+		if ( finished ){
+			break;
+		}
+		// Disk has caught up with computation
+		output_sum.flush();
+	}
+	output_sum.flush();
+}
@@ -0,0 +1,113 @@
+#ifndef _OUTPUT_HPP
+#define _OUTPUT_HPP
+
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "freddi_evolution.hpp"
+#include "fulldata.hpp"
+#include "spsc_queue.hpp"
+
+
+// bands are names of photometric bands, first_names and first_units are used
+// to add extra columns before the standard ones
+void write_summary_header(std::ostream &output, const std::vector<std::string> &bands, const std::string &first_names = "", const std::string &first_units = "");
+void write_summary_row(std::ostream &output, const FreddiSummary &s);
+// Value of the column of write_summary_row with the name from the header,
+// e.g. "Lx" or "mV", in the same units. Throws std::invalid_argument for
+// unknown name
+double summary_column(const FreddiSummary &s, const std::vector<std::string> &bands, const std::string &name);
+
+
+// Chooses time steps to output according to --outputevery, --outputtimes and
+// --outputlog
+class OutputSchedule{
+private:
+	const int every;
+	// Sorted requested times, including logarithmically spaced ones
+	std::vector<double> times;
+	size_t next_time;
+
+public:
+	// Times not later than freddi.t are skipped, they are output before restart
+	explicit OutputSchedule(const FreddiEvolution &freddi);
+	// Whether the last computed step should be output, it should be called
+	// once for every step
+	bool due(const FreddiEvolution &freddi);
+};
+
+
+// PREFIX_telemetry.dat: a row for every time step and summary table at the end
+class TelemetryFile{
+private:
+	std::ofstream output;
+	const std::chrono::steady_clock::time_point start;
+	StepTelemetry total;
+	int steps, iterations, max_iterations, heuristic_steps;
+	double max_residual;
+
+public:
+	explicit TelemetryFile(const std::string &filename);
+	// Writes summary table
+	~TelemetryFile();
+	void write(const FreddiEvolution &freddi, double output_seconds);
+};
+
+
+// Output data of one time step
+struct OutputSnapshot{
+	FreddiSummary summary;
+	int i_t;
+	double t, Mdot_in;
+	// Columns of fulldata file, the first point of the grid is skipped
+	std::array<vecd, fulldata_columns> columns;
+};
+
+
+// Writes PREFIX.dat and, if it is asked, PREFIX_%d.dat or PREFIX_fulldata.bin
+// files. Files are written by separate thread: dump() copies the current step
+// into one of recycled snapshots and passes it to the writer through
+// lock-free queue. If all snapshots are waiting for the writer then dump()
+// waits too, so memory usage is bounded when disk is slower than computation
+class FreddiFileOutput{
+private:
+	static const int queue_size = 8;
+
+	const FreddiEvolution &freddi;
+	std::ofstream output_sum;
+	// PREFIX_obs.dat, it is written by the main thread
+	std::ofstream output_obs;
+	std::unique_ptr<TelemetryFile> telemetry;
+	// Time spent by dump() and dump_observations() for the current step
+	double output_seconds;
+	std::unique_ptr<FulldataBinaryWriter> fulldata_binary;
+	std::vector<std::unique_ptr<OutputSnapshot>> snapshots;
+	SpscQueue<OutputSnapshot *> queue, free_snapshots;
+	std::atomic<bool> done;
+	std::thread writer;
+
+	void write(const OutputSnapshot &snapshot);
+	void write_loop();
+
+public:
+	FreddiFileOutput(const FreddiEvolution &freddi, const std::string &cmdline);
+	// Waits until all dumped steps are written
+	~FreddiFileOutput();
+	void dump();
+	// Writes freddi.observations, it should be called after every step
+	void dump_observations();
+	// Writes freddi.telemetry if --telemetry is specified, it should be called
+	// after every step
+	void dump_telemetry();
+};
+
+
+#endif // _OUTPUT_HPP
@@ -0,0 +1,151 @@
+#include "photometry.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "arguments.hpp"
+
+
+using namespace std;
+
+
+Photometry::Photometry(){
+	// Allen's Astrophysical Quantities (4th ed.)
+	add_band("U", "4.22e-9", {3600. * Angstrem}, {1.});
+	add_band("B", "6.4e-9", {4400. * Angstrem}, {1.});
+	add_band("V", "3.750e-9", {5500. * Angstrem}, {1.});
+	add_band("R", "1.75e-9", {7100. * Angstrem}, {1.});
+	add_band("I", "0.84e-9", {9700. * Angstrem}, {1.});
+	// Campins et al., 1985, AJ, 90, 896
+	add_band("J", "1600Jy", {12600. * Angstrem}, {1.});
+}
+
+
+Photometry::Photometry(const string &filename){
+	ifstream input(filename);
+	if ( not input ){
+		throw invalid_argument("Cannot open filter file " + filename);
+	}
+	const auto slash = filename.rfind('/');
+	const string dir = slash == string::npos ? "" : filename.substr(0, slash + 1);
+
+	string line;
+	while ( getline(input, line) ){
+		istringstream tokens(line);
+		string name, zero_point, wavelength;
+		if ( not (tokens >> name) or name.front() == '#' ){
+			continue;
+		}
+		if ( not (tokens >> zero_point >> wavelength) ){
+			throw invalid_argument("Wrong line in filter file " + filename + ": " + line);
+		}
+
+		istringstream wavelength_stream(wavelength);
+		double lambda_eff;
+		if ( wavelength_stream >> lambda_eff and wavelength_stream.eof() ){
+			add_band(name, zero_point, {lambda_eff * Angstrem}, {1.});
+			continue;
+		}
+
+		const string curve_filename = wavelength.front() == '/' ? wavelength : dir + wavelength;
+		ifstream curve(curve_filename);
+		if ( not curve ){
+			throw invalid_argument("Cannot open transmission curve file " + curve_filename);
+		}
+		vector<double> lambda, transmission;
+		string curve_line;
+		while ( getline(curve, curve_line) ){
+			istringstream values(curve_line);
+			double l, T;
+			if ( curve_line.empty() or curve_line.front() == '#' or not (values >> l >> T) ){
+				continue;
+			}
+			lambda.push_back(l * Angstrem);
+			transmission.push_back(T);
+		}
+		add_band(name, zero_point, lambda, transmission);
+	}
+	if ( bands.empty() ){
+		throw invalid_argument("Filter file " + filename + " has no bands");
+	}
+}
+
+
+void Photometry::add_band(const string &name, const string &zero_point, const vector<double> &band_lambda, const vector<double> &transmission){
+	PhotometricBand band;
+	band.name = name;
+	band.lambda = band_lambda;
+
+	const int N = band_lambda.size();
+	if ( N == 1 ){
+		band.weight = {1.};
+	} else{
+		if ( N == 0 ){
+			throw invalid_argument("Transmission curve of band " + name + " is empty");
+		}
+		band.weight.assign(N, 0.);
+		double norm = 0.;
+		for ( int i = 0; i < N-1; ++i ){
+			if ( band_lambda[i+1] <= band_lambda[i] ){
+				throw invalid_argument("Wavelengths of transmission curve of band " + name + " should increase");
+			}
+			const double step = 0.5 * ( band_lambda[i+1] - band_lambda[i] );
+			band.weight[i] += transmission[i] * step;
+			band.weight[i+1] += transmission[i+1] * step;
+			norm += ( transmission[i] + transmission[i+1] ) * step;
+		}
+		if ( norm <= 0. ){
+			throw invalid_argument("Transmission curve of band " + name + " is zero");
+		}
+		for ( auto &w : band.weight ){
+			w /= norm;
+		}
+	}
+
+	istringstream zero_point_stream(zero_point);
+	double irr0;
+	string unit;
+	zero_point_stream >> irr0 >> unit;
+	if ( zero_point_stream.fail() and not zero_point_stream.eof() ){
+		throw invalid_argument("Wrong zero point of band " + name + ": " + zero_point);
+	}
+	if ( unit.empty() ){
+		band.irr0 = irr0 / Angstrem;
+	} else if ( unit == "Jy" ){
+		// F_lambda = F_nu c / lambda^2 averaged over the band
+		band.irr0 = 0.;
+		for ( int i = 0; i < N; ++i ){
+			band.irr0 += band.weight[i] * irr0 * Jy * GSL_CONST_CGSM_SPEED_OF_LIGHT / (band_lambda[i] * band_lambda[i]);
+		}
+	} else{
+		throw invalid_argument("Wrong zero point of band " + name + ": " + zero_point);
+	}
+
+	bands.push_back(band);
+	lambda.insert(lambda.end(), band_lambda.begin(), band_lambda.end());
+	I_lambda.resize(lambda.size());
+}
+
+
+vector<string> Photometry::names() const{
+	vector<string> v;
+	for ( const auto &band : bands ){
+		v.push_back(band.name);
+	}
+	return v;
+}
+
+
+void Photometry::magnitudes(const RadialSpectrum &spectrum, const double cosiOverD2, vector<double> &m){
+	spectrum.I_lambda(lambda, I_lambda);
+	m.resize(bands.size());
+	size_t i_lambda = 0;
+	for ( size_t i = 0; i < bands.size(); ++i ){
+		double I = 0.;
+		for ( const double w : bands[i].weight ){
+			I += w * I_lambda[i_lambda++];
+		}
+		m[i] = -2.5 * log10( I * cosiOverD2 / bands[i].irr0 );
+	}
+}
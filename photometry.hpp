@@ -0,0 +1,48 @@
+#ifndef _PHOTOMETRY_HPP
+#define _PHOTOMETRY_HPP
+
+
+#include <string>
+#include <vector>
+
+#include "spectrum.hpp"
+
+
+// Photometric band. Flux density is averaged over transmission curve,
+// <F_lambda> = \int F_lambda T dlambda / \int T dlambda, so weights are
+// normalised trapezoid weights of T. Band given by effective wavelength has
+// one point with unit weight
+struct PhotometricBand{
+	std::string name;
+	std::vector<double> lambda, weight; // cm
+	double irr0; // zero point flux density, erg/s/cm^2/cm
+};
+
+
+// Magnitudes of the disk in a set of bands. All wavelengths of all bands are
+// integrated over the disk by one pass over the radial grid
+class Photometry{
+private:
+	std::vector<double> lambda, I_lambda;
+
+	void add_band(const std::string &name, const std::string &zero_point, const std::vector<double> &lambda, const std::vector<double> &transmission);
+
+public:
+	std::vector<PhotometricBand> bands;
+
+	// Standard U, B, V, R, I and J bands
+	Photometry();
+	// Filter file consists of lines 'NAME ZERO_POINT WAVELENGTH', where
+	// ZERO_POINT is F_lambda in erg/s/cm^2/A or F_nu in Jy with suffix Jy, and
+	// WAVELENGTH is effective wavelength in A or the name of two-column file
+	// with wavelengths in A and transmission, relative to the filter file.
+	// Lines started with # are ignored
+	explicit Photometry(const std::string &filename);
+
+	std::vector<std::string> names() const;
+	// Writes magnitudes of all bands to m, cosiOverD2 is cos(i) / Distance^2
+	void magnitudes(const RadialSpectrum &spectrum, double cosiOverD2, std::vector<double> &m);
+};
+
+
+#endif // _PHOTOMETRY_HPP
@@ -0,0 +1,122 @@
+#ifndef _SIMD_MATH_HPP
+#define _SIMD_MATH_HPP
+
+
+#include <cstdint>
+#include <cstring>	// std::memcpy
+#include <limits>
+
+
+// Functions below are branch-free versions of exp, log and pow for double
+// arguments, so compiler can vectorise loops calling them, which isn't the
+// case for libm functions. Relative error of exp and log is about 1e-16,
+// relative error of pow(x, p) is about 1e-16 * |p * log(x)|
+//
+// Loops using them should be compiled with FREDDI_TARGET_CLONES attribute
+// to use AVX2 or AVX-512 instructions if they are available on the machine
+
+
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__) && !defined(__clang__)
+#define FREDDI_TARGET_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define FREDDI_TARGET_CLONES
+#endif
+
+
+namespace simd_math{
+
+inline double as_double(const uint64_t i){
+	double x;
+	std::memcpy(&x, &i, sizeof(x));
+	return x;
+}
+
+inline uint64_t as_uint64(const double x){
+	uint64_t i;
+	std::memcpy(&i, &x, sizeof(i));
+	return i;
+}
+
+const double ln2_hi = 6.93147180369123816490e-01;
+const double ln2_lo = 1.90821492927058770002e-10;
+
+} // namespace simd_math
+
+
+// exp(x), values of x < -700 give 0, values of x > 709 give +inf
+inline double exp_simd(const double x){
+	using namespace simd_math;
+	const double log2e = 1.44269504088896338700e+00;
+	const double shifter = 0x1.8p52;
+	const double xc = x < -700. ? -700. : ( x > 709. ? 709. : x );
+	const double kd = xc * log2e + shifter; // the lowest bits of kd contain round(xc / ln2)
+	const double k = kd - shifter;
+	const double r = ( xc - k * ln2_hi ) - k * ln2_lo;
+	// Taylor series, |r| < 0.35
+	double p = 1./6227020800.;
+	p = p * r + 1./479001600.;
+	p = p * r + 1./39916800.;
+	p = p * r + 1./3628800.;
+	p = p * r + 1./362880.;
+	p = p * r + 1./40320.;
+	p = p * r + 1./5040.;
+	p = p * r + 1./720.;
+	p = p * r + 1./120.;
+	p = p * r + 1./24.;
+	p = p * r + 1./6.;
+	p = p * r + 0.5;
+	p = p * r + 1.;
+	p = p * r + 1.;
+	const double scale = as_double( ( as_uint64(kd) + 1023 ) << 52 );
+	const double e = p * scale;
+	return x < -700. ? 0. : ( x > 709. ? std::numeric_limits<double>::infinity() : e );
+}
+
+
+// Natural logarithm for normal positive x, log(0) = -inf, log(x < 0) = NaN
+inline double log_simd(const double x){
+	using namespace simd_math;
+	// Coefficients from fdlibm e_log.c
+	const double Lg1 = 6.666666666666735130e-01;
+	const double Lg2 = 3.999999999940941908e-01;
+	const double Lg3 = 2.857142874366239149e-01;
+	const double Lg4 = 2.222219843214978396e-01;
+	const double Lg5 = 1.818357216161805012e-01;
+	const double Lg6 = 1.531383769920937332e-01;
+	const double Lg7 = 1.479819860511658591e-01;
+	const double sqrt2 = 1.41421356237309504880;
+
+	const uint64_t bits = as_uint64(x);
+	// Exponent and mantissa in [1, 2)
+	const double e_biased = as_double( (bits >> 52) | 0x4330000000000000ULL ) - 0x1p52;
+	const double m = as_double( (bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL );
+	// Move mantissa to [sqrt(2)/2, sqrt(2))
+	const double dk = m > sqrt2 ? e_biased - 1022. : e_biased - 1023.;
+	const double f = ( m > sqrt2 ? 0.5 * m : m ) - 1.;
+
+	const double s = f / (2. + f);
+	const double z = s * s;
+	const double w = z * z;
+	const double t1 = w * (Lg2 + w * (Lg4 + w * Lg6));
+	const double t2 = z * (Lg1 + w * (Lg3 + w * (Lg5 + w * Lg7)));
+	const double R = t2 + t1;
+	const double hfsq = 0.5 * f * f;
+	const double l = dk * ln2_hi - ( ( hfsq - ( s * (hfsq + R) + dk * ln2_lo ) ) - f );
+	// Special values are selected by integer masks instead of comparisons,
+	// otherwise compiler makes branches when log_simd() result is passed to exp_simd()
+	const uint64_t negative = static_cast<uint64_t>( static_cast<int64_t>(bits) >> 63 );
+	const uint64_t zero = ( (bits | (0 - bits)) >> 63 ) - 1;
+	const uint64_t minus_inf = 0xfff0000000000000ULL;
+	const uint64_t nan = 0x7ff8000000000000ULL;
+	const uint64_t result = ( as_uint64(l) & ~zero & ~negative ) | ( minus_inf & zero ) | ( nan & negative );
+	return as_double(result);
+}
+
+
+// x^p for x >= 0
+inline double pow_simd(const double x, const double p){
+	return exp_simd( p * log_simd(x) );
+}
+
+
+#endif // _SIMD_MATH_HPP
@@ -1,20 +1,128 @@
 #include "spectrum.hpp"
 
-double Luminosity( const std::vector<double> &R, const std::vector<double> &T, double min_nu, double max_nu, int Nnu ){
-	const int NR = fmin(R.size(), T.size());
+#include <algorithm>  // std::equal, std::min
+
+#include "simd_math.hpp"
+
+
+// ln of \int_x1^x2 t^3 / (e^t - 1) dt by Simpson rule. The integrand is
+// multiplied by e^x1 to avoid underflow and is neglected for t > x1 + 40
+static double ln_planck_integral(const double x1, double x2, int N){
+	x2 = fmin(x2, x1 + 40.);
+	N += N % 2;
+	const double step = ( x2 - x1 ) / N;
+	double sum = 0.;
+	for ( int i = 0; i <= N; ++i ){
+		const double x = x1 + step * i;
+		const double f = x * x * x * exp( x1 - x ) / ( -expm1(-x) );
+		if ( i == 0 or i == N ){
+			sum += f;
+		} else{
+			sum += ( i % 2 == 1 ? 4. : 2. ) * f;
+		}
+	}
+	return -x1 + log( sum * step / 3. );
+}
+
+
+BandEmissivity::BandEmissivity(const double min_nu, const double max_nu, const int N_T, const int Nnu){
+	if ( min_nu <= 0. or max_nu <= min_nu ){
+		throw std::invalid_argument("Wrong frequency band for BandEmissivity");
+	}
+	if ( N_T < 4 ){
+		throw std::invalid_argument("BandEmissivity table should have at least four points");
+	}
+	const double h_over_k = GSL_CONST_CGSM_PLANCKS_CONSTANT_H / GSL_CONST_CGSM_BOLTZMANN;
+	// exp(-h min_nu / k T) underflows for T < T_first, h max_nu / k T_last = 1e-6
+	const double T_first = h_over_k * min_nu / 700.;
+	const double T_last = h_over_k * max_nu * 1e6;
+	ln_T_first = log(T_first);
+	step_ln_T = ( log(T_last) - ln_T_first ) / (N_T - 1.);
+	ln_B.resize(N_T);
+	for ( int i = 0; i < N_T; ++i ){
+		const double T = exp( ln_T_first + step_ln_T * i );
+		// B_nu dnu = 2 k^4 T^4 / h^3 c^2 * x^3 / (e^x - 1) dx, where x = h nu / k T
+		ln_B[i] = log( 2. * pow(GSL_CONST_CGSM_BOLTZMANN * T, 4.) / pow(GSL_CONST_CGSM_PLANCKS_CONSTANT_H, 3.) / GSL_CONST_CGSM_SPEED_OF_LIGHT / GSL_CONST_CGSM_SPEED_OF_LIGHT )
+			+ ln_planck_integral( h_over_k * min_nu / T, h_over_k * max_nu / T, Nnu );
+	}
+}
+
+
+// Branch-free, so it can be used in vectorised loops
+inline static double band_emissivity(const double * __restrict ln_B, const int N_T, const double ln_T_first, const double step_ln_T, const double inv_T){
+	const double u = ( - log_simd(inv_T) - ln_T_first ) / step_ln_T;
+	const double u_last = N_T - 1.;
+	const double uc = u < 0. ? 0. : ( u > u_last ? u_last : u );
+	int j = static_cast<int>(uc);
+	j = j < 1 ? 1 : ( j > N_T - 3 ? N_T - 3 : j );
+	// Lagrange polynomial over nodes j-1, j, j+1, j+2
+	const double p = uc - j;
+	const double ln_B_interp =
+		- p * (p - 1.) * (p - 2.) / 6. * ln_B[j-1]
+		+ (p + 1.) * (p - 1.) * (p - 2.) / 2. * ln_B[j]
+		- (p + 1.) * p * (p - 2.) / 2. * ln_B[j+1]
+		+ (p + 1.) * p * (p - 1.) / 6. * ln_B[j+2];
+	// B ~ T in Rayleigh-Jeans limit
+	const double ln_B_value = ln_B_interp + step_ln_T * ( u - uc );
+	return u < 0. ? 0. : exp_simd(ln_B_value);
+}
+
+
+double BandEmissivity::operator()(const double inv_T) const{
+	return band_emissivity(ln_B.data(), ln_B.size(), ln_T_first, step_ln_T, inv_T);
+}
+
+
+FREDDI_TARGET_CLONES
+static double band_sum(const double * __restrict weight, const double * __restrict inv_T, const double * __restrict ln_B, const int N_T, const double ln_T_first, const double step_ln_T, const int first, const int last){
+	double sum = 0.;
+	#pragma omp simd reduction(+:sum)
+	for ( int i = first; i <= last; ++i ){
+		sum += weight[i] * band_emissivity(ln_B, N_T, ln_T_first, step_ln_T, inv_T[i]);
+	}
+	return sum;
+}
+
+
+double BandEmissivity::sum(const double *weight, const double *inv_T, const int first, const int last) const{
+	return band_sum(weight, inv_T, ln_B.data(), ln_B.size(), ln_T_first, step_ln_T, first, last);
+}
+
+
+// Sum of area_i / (exp(x_coef / T_i) - 1) for first <= i <= last
+FREDDI_TARGET_CLONES
+static double planck_sum(const double * __restrict area, const double * __restrict inv_T, const double x_coef, const int first, const int last){
+	double sum = 0.;
+	#pragma omp simd reduction(+:sum)
+	for ( int i = first; i <= last; ++i ){
+		sum += area[i] / ( exp_simd( x_coef * inv_T[i] ) - 1. );
+	}
+	return sum;
+}
+
+
+void RadialSpectrum::set(const std::vector<double> &R, const std::vector<double> &T){
+	NR = fmin(R.size(), T.size());
+	area.resize(NR);
+	inv_T.resize(NR);
+	for ( int i_R = 0; i_R < NR; ++i_R ){
+		double stepR;
+		if ( i_R == 0               ) stepR = R[i_R+1] - R[i_R  ];
+		if ( i_R == NR-1            ) stepR = R[i_R  ] - R[i_R-1];
+		if ( i_R > 0 and i_R < NR-1 ) stepR = R[i_R+1] - R[i_R-1];
+		area[i_R] = .5 * 2. * M_PI * R[i_R] * stepR;
+		inv_T[i_R] = 1. / T[i_R];
+	}
+}
+
+
+double RadialSpectrum::Luminosity(const double min_nu, const double max_nu, const int Nnu) const{
 	const double step_nu = Nnu > 1.  ?  ( max_nu - min_nu ) / (Nnu-1.)  :  1.;
 	double L = 0;
 	for ( int i_nu = 0; i_nu < Nnu; ++i_nu ){
 		const double nu = min_nu + step_nu * i_nu;
-		double Inu = 0;
-		for ( int i_R = 0; i_R < NR; ++i_R ){
-			double stepR;
-			if ( i_R == 0               ) stepR = R.at(i_R+1) - R.at(i_R  );
-			if ( i_R == NR-1            ) stepR = R.at(i_R  ) - R.at(i_R-1);
-			if ( i_R > 1 and i_R < NR-1 ) stepR = R.at(i_R+1) - R.at(i_R-1);
-			const double Bnu = 2. * GSL_CONST_CGSM_PLANCKS_CONSTANT_H * nu * nu * nu / GSL_CONST_CGSM_SPEED_OF_LIGHT / GSL_CONST_CGSM_SPEED_OF_LIGHT / ( exp( nu*GSL_CONST_CGSM_PLANCKS_CONSTANT_H / GSL_CONST_CGSM_BOLTZMANN / T.at(i_R) ) - 1. );
-			Inu += .5 * Bnu * 2. * M_PI * R.at(i_R) * stepR;
-		}
+		const double Bnu_coef = 2. * GSL_CONST_CGSM_PLANCKS_CONSTANT_H * nu * nu * nu / GSL_CONST_CGSM_SPEED_OF_LIGHT / GSL_CONST_CGSM_SPEED_OF_LIGHT;
+		const double Inu = Bnu_coef * planck_sum( area.data(), inv_T.data(), nu * GSL_CONST_CGSM_PLANCKS_CONSTANT_H / GSL_CONST_CGSM_BOLTZMANN, 0, NR-1 );
 		if ( (i_nu == 0 or i_nu == Nnu-1) and Nnu > 1. ){
 			L += Inu / 2.;
 		} else{
@@ -26,19 +134,44 @@ double Luminosity( const std::vector<double> &R, const std::vector<double> &T, d
 }
 
 
+double RadialSpectrum::Luminosity(const BandEmissivity &band) const{
+	return 2. * M_PI * band.sum(area.data(), inv_T.data(), 0, NR-1);
+}
 
-double I_lambda( const std::vector<double> &R, const std::vector<double> &T, double lambda ){
-	double I = 0;
-	int NR = fmin(R.size(), T.size());
-	for ( int i_R = 1; i_R < NR; ++i_R ){
-		double stepR;
-		if ( i_R == 0              ) stepR = R.at(i_R+1) - R.at(i_R  );
-		if ( i_R == NR-1           ) stepR = R.at(i_R  ) - R.at(i_R-1);
-		if ( i_R > 1 and i_R < NR-1 ) stepR = R.at(i_R+1) - R.at(i_R-1);
-		const double B_lambda =  2. * GSL_CONST_CGSM_PLANCKS_CONSTANT_H * GSL_CONST_CGSM_SPEED_OF_LIGHT * GSL_CONST_CGSM_SPEED_OF_LIGHT / pow(lambda,5.) / ( exp( GSL_CONST_CGSM_SPEED_OF_LIGHT * GSL_CONST_CGSM_PLANCKS_CONSTANT_H / lambda / GSL_CONST_CGSM_BOLTZMANN / T.at(i_R) ) - 1. );
-		I += .5 * B_lambda * 2. * M_PI * R.at(i_R) * stepR;
+
+double RadialSpectrum::I_lambda(const double lambda) const{
+	const double B_lambda_coef = 2. * GSL_CONST_CGSM_PLANCKS_CONSTANT_H * GSL_CONST_CGSM_SPEED_OF_LIGHT * GSL_CONST_CGSM_SPEED_OF_LIGHT / pow(lambda,5.);
+	return B_lambda_coef * planck_sum( area.data(), inv_T.data(), GSL_CONST_CGSM_SPEED_OF_LIGHT * GSL_CONST_CGSM_PLANCKS_CONSTANT_H / lambda / GSL_CONST_CGSM_BOLTZMANN, 1, NR-1 );
+}
+
+
+void RadialSpectrum::I_lambda(const std::vector<double> &lambda, std::vector<double> &I) const{
+	const int block = 1024;
+	const int N_lambda = lambda.size();
+	I.assign(N_lambda, 0.);
+	for ( int first = 1; first < NR; first += block ){
+		const int last = std::min(first + block - 1, NR - 1);
+		for ( int i = 0; i < N_lambda; ++i ){
+			I[i] += planck_sum( area.data(), inv_T.data(), GSL_CONST_CGSM_SPEED_OF_LIGHT * GSL_CONST_CGSM_PLANCKS_CONSTANT_H / lambda[i] / GSL_CONST_CGSM_BOLTZMANN, first, last );
+		}
+	}
+	for ( int i = 0; i < N_lambda; ++i ){
+		I[i] *= 2. * GSL_CONST_CGSM_PLANCKS_CONSTANT_H * GSL_CONST_CGSM_SPEED_OF_LIGHT * GSL_CONST_CGSM_SPEED_OF_LIGHT / pow(lambda[i],5.);
 	}
-	return I;
+}
+
+
+double Luminosity( const std::vector<double> &R, const std::vector<double> &T, double min_nu, double max_nu, int Nnu ){
+	RadialSpectrum spectrum;
+	spectrum.set(R, T);
+	return spectrum.Luminosity(min_nu, max_nu, Nnu);
+}
+
+
+double I_lambda( const std::vector<double> &R, const std::vector<double> &T, double lambda ){
+	RadialSpectrum spectrum;
+	spectrum.set(R, T);
+	return spectrum.I_lambda(lambda);
 }
 
 
@@ -67,3 +200,16 @@ double T_GR( const double r1, const double ak, const double Mx, const double Mdo
 
     );
 }
+
+
+const std::vector<double>& TemperatureGRProfile::factors(const std::vector<double> &R, const int N){
+	if ( this->R.size() >= static_cast<size_t>(N) and std::equal(R.begin(), R.begin() + N, this->R.begin()) ){
+		return f;
+	}
+	this->R.assign(R.begin(), R.begin() + N);
+	f.resize(N);
+	for ( int i = 0; i < N; ++i ){
+		f[i] = T_GR( R[i], kerr, Mx, 1., R[0] );
+	}
+	return f;
+}
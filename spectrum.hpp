@@ -4,11 +4,53 @@
 
 
 #include <cmath>
+#include <stdexcept>
 #include <vector>
 
 #include "gsl_const_cgsm.h"
 
 
+// Planck function integrated over frequency band [min_nu, max_nu] as a
+// function of temperature. It is tabulated once on uniform grid of ln T by
+// Simpson rule over Nnu frequencies, values between nodes are found by cubic
+// interpolation of ln of the integral. Temperatures below the table give zero,
+// temperatures above it are in Rayleigh-Jeans limit
+class BandEmissivity{
+private:
+	double ln_T_first, step_ln_T;
+	std::vector<double> ln_B;
+
+public:
+	BandEmissivity(double min_nu, double max_nu, int N_T, int Nnu);
+	// \int B_nu dnu over the band for temperature T = 1 / inv_T, erg/s/cm^2/sr
+	double operator()(double inv_T) const;
+	// Sum of weight_i * operator()(inv_T_i) for first <= i <= last, it is vectorised
+	double sum(const double *weight, const double *inv_T, int first, int last) const;
+};
+
+
+// Disk annuli prepared for integration of the Planck function: structure of
+// arrays with area of the ring pi R_i stepR_i and 1/T_i. Object keeps its
+// buffers between calls of set(), integration loops are vectorised
+class RadialSpectrum{
+private:
+	std::vector<double> area, inv_T;
+	int NR = 0;
+
+public:
+	void set(const std::vector<double> &R, const std::vector<double> &T);
+	// Luminosity of one side of the disk in [min_nu, max_nu], trapezoid rule over Nnu frequencies
+	double Luminosity(double min_nu, double max_nu, int Nnu) const;
+	// The same with band integral taken from the table
+	double Luminosity(const BandEmissivity &band) const;
+	// Integral of B_lambda over one side of the disk excluding the first point
+	double I_lambda(double lambda) const;
+	// The same for many wavelengths at once, the radial grid is passed by
+	// blocks fitting into L1 cache and every block is used for all wavelengths
+	void I_lambda(const std::vector<double> &lambda, std::vector<double> &I) const;
+};
+
+
 double Luminosity(const std::vector<double> &R, const std::vector<double> &T, double min_nu, double max_nu, int Nnu);
 
 double I_lambda( const std::vector<double> &R, const std::vector<double> &T, double lambda );
@@ -16,4 +58,18 @@ double I_lambda( const std::vector<double> &R, const std::vector<double> &T, dou
 double T_GR( const double r1, const double ak, const double Mx, const double Mdot, const double r_in  );
 
 
+// Factors f_i of T_GR(R_i, kerr, Mx, Mdot, R_0) = f_i Mdot^(1/4). They depend
+// on the grid only and are recomputed only if the first N radii are changed,
+// so shrinking of the grid by the outer boundary doesn't recompute them
+class TemperatureGRProfile{
+private:
+	const double kerr, Mx;
+	std::vector<double> R, f;
+
+public:
+	TemperatureGRProfile(double kerr, double Mx): kerr(kerr), Mx(Mx) {}
+	const std::vector<double>& factors(const std::vector<double> &R, int N);
+};
+
+
 #endif // _SPECTRUM_HPP
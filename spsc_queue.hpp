@@ -0,0 +1,48 @@
+#ifndef _SPSC_QUEUE_HPP
+#define _SPSC_QUEUE_HPP
+
+
+#include <atomic>
+#include <cstddef>
+#include <utility>	// std::move
+#include <vector>
+
+
+// Bounded lock-free queue for one producer thread and one consumer thread.
+// push() and pop() never block, they return false if the queue is full or
+// empty respectively
+template <typename T>
+class SpscQueue{
+private:
+	std::vector<T> items;
+	std::atomic<size_t> head; // next item to pop
+	std::atomic<size_t> tail; // next place to push
+
+public:
+	explicit SpscQueue(const size_t capacity):
+		items(capacity + 1), head(0), tail(0) {}
+
+	bool push(T x){
+		const size_t t = tail.load(std::memory_order_relaxed);
+		const size_t next = ( t + 1 ) % items.size();
+		if ( next == head.load(std::memory_order_acquire) ){
+			return false;
+		}
+		items[t] = std::move(x);
+		tail.store(next, std::memory_order_release);
+		return true;
+	}
+
+	bool pop(T &x){
+		const size_t h = head.load(std::memory_order_relaxed);
+		if ( h == tail.load(std::memory_order_acquire) ){
+			return false;
+		}
+		x = std::move(items[h]);
+		head.store(( h + 1 ) % items.size(), std::memory_order_release);
+		return true;
+	}
+};
+
+
+#endif // _SPSC_QUEUE_HPP
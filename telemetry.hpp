@@ -0,0 +1,72 @@
+#ifndef _TELEMETRY_HPP
+#define _TELEMETRY_HPP
+
+
+#include <chrono>
+
+
+// Solver statistics and wall time of parts of one time step in addition to
+// FreddiEvolution::Niter, see --telemetry. Times are in seconds, they are
+// measured only if telemetry is enabled
+struct StepTelemetry{
+	// Final relative difference between the last two iterations
+	double residual = 0.;
+	// Whether divergence heuristic of the solver fired for some attempt
+	bool divergence_heuristic = false;
+	double solve = 0.;
+	// Part of solve spent in W(h, F) evaluations
+	double wunc = 0.;
+	double spectrum = 0.;
+	double photometry = 0.;
+	double output = 0.;
+};
+
+
+// Adds wall time of its scope to *seconds, does nothing if seconds is null
+class ScopedTimer{
+private:
+	double *seconds;
+	std::chrono::steady_clock::time_point start;
+
+public:
+	explicit ScopedTimer(double *seconds):
+		seconds(seconds)
+	{
+		if ( seconds != nullptr ){
+			start = std::chrono::steady_clock::now();
+		}
+	}
+
+	~ScopedTimer(){
+		if ( seconds != nullptr ){
+			*seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+	}
+};
+
+
+// Wunc functor adding time of every call to seconds, it is used instead of
+// Wunc only if telemetry is enabled
+template <typename Wunc>
+class TimedWunc{
+private:
+	const Wunc &wunc;
+	double &seconds;
+
+public:
+	TimedWunc(const Wunc &wunc, double &seconds):
+		wunc(wunc), seconds(seconds) {}
+
+	void operator()(const double *h, const double *F, double *W, int first, int last) const{
+		ScopedTimer timer(&seconds);
+		wunc(h, F, W, first, last);
+	}
+
+	void derivative(const double *h, const double *F, const double *W, double *dWdF, int first, int last) const{
+		ScopedTimer timer(&seconds);
+		wunc.derivative(h, F, W, dWdF, first, last);
+	}
+};
+
+
+#endif // _TELEMETRY_HPP
@@ -0,0 +1,118 @@
+#include "thread_pool.hpp"
+
+
+using namespace std;
+
+
+ThreadPool::ThreadPool(unsigned int n_threads):
+	done(false),
+	next_queue(0),
+	queued(0),
+	unfinished(0)
+{
+	if ( n_threads == 0 ){
+		n_threads = thread::hardware_concurrency();
+	}
+	if ( n_threads == 0 ){
+		n_threads = 1;
+	}
+	for ( unsigned int i = 0; i < n_threads; ++i ){
+		queues.emplace_back(new Queue);
+	}
+	for ( unsigned int i = 0; i < n_threads; ++i ){
+		threads.emplace_back(&ThreadPool::work, this, i);
+	}
+}
+
+
+ThreadPool::~ThreadPool(){
+	{
+		lock_guard<std::mutex> lock(mutex);
+		done = true;
+	}
+	task_added.notify_all();
+	for ( auto &thread : threads ){
+		thread.join();
+	}
+}
+
+
+void ThreadPool::submit(function<void()> task){
+	const size_t i = next_queue++ % queues.size();
+	{
+		lock_guard<std::mutex> lock(mutex);
+		++unfinished;
+	}
+	{
+		lock_guard<std::mutex> lock(queues[i]->mutex);
+		queues[i]->tasks.push_back(move(task));
+	}
+	{
+		lock_guard<std::mutex> lock(mutex);
+		++queued;
+	}
+	task_added.notify_one();
+}
+
+
+bool ThreadPool::pop(const size_t i, function<void()> &task){
+	{
+		lock_guard<std::mutex> lock(queues[i]->mutex);
+		if ( not queues[i]->tasks.empty() ){
+			task = move(queues[i]->tasks.back());
+			queues[i]->tasks.pop_back();
+			--queued;
+			return true;
+		}
+	}
+	for ( size_t j = 1; j < queues.size(); ++j ){
+		Queue &victim = *queues[(i + j) % queues.size()];
+		lock_guard<std::mutex> lock(victim.mutex);
+		if ( not victim.tasks.empty() ){
+			task = move(victim.tasks.front());
+			victim.tasks.pop_front();
+			--queued;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+void ThreadPool::work(const size_t i){
+	function<void()> task;
+	while ( true ){
+		if ( pop(i, task) ){
+			try{
+				task();
+			} catch (...){
+				lock_guard<std::mutex> lock(mutex);
+				if ( not exception ){
+					exception = current_exception();
+				}
+			}
+			task = nullptr;
+			lock_guard<std::mutex> lock(mutex);
+			if ( --unfinished == 0 ){
+				task_finished.notify_all();
+			}
+			continue;
+		}
+		unique_lock<std::mutex> lock(mutex);
+		task_added.wait(lock, [this]{ return done or queued > 0; });
+		if ( done and queued == 0 ){
+			return;
+		}
+	}
+}
+
+
+void ThreadPool::wait(){
+	unique_lock<std::mutex> lock(mutex);
+	task_finished.wait(lock, [this]{ return unfinished == 0; });
+	if ( exception ){
+		auto e = exception;
+		exception = nullptr;
+		rethrow_exception(e);
+	}
+}
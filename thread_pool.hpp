@@ -0,0 +1,53 @@
+#ifndef _THREAD_POOL_HPP
+#define _THREAD_POOL_HPP
+
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// Pool of threads with work stealing: every worker has its own queue, it takes
+// tasks from the back of its queue and steals from the front of others' queues
+// when its own queue is empty
+class ThreadPool{
+private:
+	struct Queue{
+		std::deque<std::function<void()>> tasks;
+		std::mutex mutex;
+	};
+
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> threads;
+	std::atomic<bool> done;
+	std::atomic<size_t> next_queue;
+	std::atomic<size_t> queued; // tasks which are in queues but not taken by workers
+
+	std::mutex mutex;
+	std::condition_variable task_added, task_finished;
+	size_t unfinished;
+	std::exception_ptr exception;
+
+	bool pop(size_t i, std::function<void()> &task);
+	void work(size_t i);
+
+public:
+	explicit ThreadPool(unsigned int n_threads = 0); // 0 means std::thread::hardware_concurrency()
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	size_t size() const { return threads.size(); }
+	void submit(std::function<void()> task);
+	// Wait until all submitted tasks are finished, rethrows the first exception thrown by a task
+	void wait();
+};
+
+
+#endif // _THREAD_POOL_HPP
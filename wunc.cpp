@@ -0,0 +1,48 @@
+#include "wunc.hpp"
+
+#include "simd_math.hpp"
+
+
+template <typename Exponents>
+FREDDI_TARGET_CLONES
+void power_law_wunc(const double * __restrict h, const double * __restrict F, double * __restrict W, const int first, const int last, const double D){
+	const double m = Exponents::m;
+	const double n = Exponents::n;
+	const double coef = 1. / (1. - m) / D;
+	if ( n == 1. ){
+		for ( int i = first; i <= last; ++i ){
+			W[i] = exp_simd( (1. - m) * log_simd(F[i]) ) * h[i] * coef;
+		}
+	} else{
+		for ( int i = first; i <= last; ++i ){
+			W[i] = exp_simd( (1. - m) * log_simd(F[i]) + n * log_simd(h[i]) ) * coef;
+		}
+	}
+}
+
+template <typename Exponents>
+FREDDI_TARGET_CLONES
+void power_law_wunc_factor(const double * __restrict factor, const double * __restrict F, double * __restrict W, const int first, const int last){
+	const double m = Exponents::m;
+	for ( int i = first; i <= last; ++i ){
+		W[i] = exp_simd( (1. - m) * log_simd(F[i]) ) * factor[i];
+	}
+}
+
+template void power_law_wunc<KramersExponents>(const double *h, const double *F, double *W, int first, int last, double D);
+template void power_law_wunc<OpalExponents>(const double *h, const double *F, double *W, int first, int last, double D);
+template void power_law_wunc_factor<KramersExponents>(const double *factor, const double *F, double *W, int first, int last);
+template void power_law_wunc_factor<OpalExponents>(const double *factor, const double *F, double *W, int first, int last);
+
+
+void RuntimePowerLawWunc::operator()(const double *h, const double *F, double *W, const int first, const int last) const{
+	if ( factor != nullptr ){
+		for ( int i = first; i <= last; ++i ){
+			W[i] = pow(F[i], 1. - m) * factor[i];
+		}
+		return;
+	}
+	for ( int i = first; i <= last; ++i ){
+		W[i] = pow(F[i], 1. - m) * pow(h[i], n) / (1. - m) / D;
+	}
+}
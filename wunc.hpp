@@ -0,0 +1,115 @@
+#ifndef _WUNC_HPP
+#define _WUNC_HPP
+
+
+#include <stdexcept>
+
+#include "opacity_related.hpp"
+
+
+// Functors calculating W(h, F) = F^(1-m) h^n / (1-m) / D for power-law
+// opacities. They write W(h_i, F_i) into W[i] for first <= i <= last. Exponents
+// of Kramers and OPAL laws are compile-time constants, so their kernels have
+// no pow() calls with variable exponents and are vectorised. Method
+// derivative() writes dW/dF = (1-m) W / F, it is used by Newton solver.
+// If array of factors h^n / (1-m) / D for the grid is given to the
+// constructor (see GridFactors) then h is ignored and only F^(1-m) is
+// calculated
+
+
+struct KramersExponents{
+	static constexpr double m = 0.3;
+	static constexpr double n = 0.8;
+};
+
+struct OpalExponents{
+	static constexpr double m = 1./3.;
+	static constexpr double n = 1.;
+};
+
+
+// Instantiated for KramersExponents and OpalExponents in wunc.cpp
+template <typename Exponents>
+void power_law_wunc(const double *h, const double *F, double *W, int first, int last, double D);
+template <typename Exponents>
+void power_law_wunc_factor(const double *factor, const double *F, double *W, int first, int last);
+
+
+inline void power_law_wunc_derivative(const double *F, const double *W, double *dWdF, const int first, const int last, const double m){
+	for ( int i = first; i <= last; ++i ){
+		dWdF[i] = (1. - m) * W[i] / F[i];
+	}
+}
+
+
+template <typename Exponents>
+class PowerLawWunc{
+public:
+	const double D;
+	const double *factor;
+
+	explicit PowerLawWunc(const OpacityRelated &oprel, const double *factor = nullptr):
+		D(oprel.D), factor(factor)
+	{
+		if ( oprel.m != Exponents::m or oprel.n != Exponents::n ){
+			throw std::invalid_argument("Exponents of PowerLawWunc don't match opacity law " + oprel.type);
+		}
+	}
+
+	void operator()(const double *h, const double *F, double *W, int first, int last) const{
+		if ( factor != nullptr ){
+			power_law_wunc_factor<Exponents>(factor, F, W, first, last);
+		} else{
+			power_law_wunc<Exponents>(h, F, W, first, last, D);
+		}
+	}
+
+	void derivative(const double *h, const double *F, const double *W, double *dWdF, int first, int last) const{
+		power_law_wunc_derivative(F, W, dWdF, first, last, Exponents::m);
+	}
+};
+
+
+// The same as PowerLawWunc but for exponents known at runtime only
+class RuntimePowerLawWunc{
+public:
+	const double m, n, D;
+	const double *factor;
+
+	explicit RuntimePowerLawWunc(const OpacityRelated &oprel, const double *factor = nullptr):
+		m(oprel.m), n(oprel.n), D(oprel.D), factor(factor) {}
+
+	void operator()(const double *h, const double *F, double *W, int first, int last) const;
+
+	void derivative(const double *h, const double *F, const double *W, double *dWdF, int first, int last) const{
+		power_law_wunc_derivative(F, W, dWdF, first, last, m);
+	}
+};
+
+
+// Tabulated opacity, W is interpolated over OpacityRelated::structure table.
+// row is GridFactors::structure_row, h is ignored
+class TabulatedWunc{
+public:
+	const VerticalStructureTable *table;
+	const double *row;
+
+	TabulatedWunc(const OpacityRelated &oprel, const double *row):
+		table(oprel.structure.get()), row(row)
+	{
+		if ( table == nullptr ){
+			throw std::invalid_argument("TabulatedWunc requires tabulated opacity, not " + oprel.type);
+		}
+	}
+
+	void operator()(const double *h, const double *F, double *W, int first, int last) const{
+		table->W(row, F, W, first, last);
+	}
+
+	void derivative(const double *h, const double *F, const double *W, double *dWdF, int first, int last) const{
+		table->dWdF(row, F, W, dWdF, first, last);
+	}
+};
+
+
+#endif // _WUNC_HPP